@@ -0,0 +1,141 @@
+/*  Relacy Race Detector
+ *  Copyright (c) 2008-2013, Dmitry S. Vyukov
+ *  All rights reserved.
+ *  This software is provided AS-IS with no warranty, either express or implied.
+ *  This software is distributed under a license and may not be copied,
+ *  modified or distributed except as expressly authorized under the
+ *  terms of the license contained in the file LICENSE in this distribution.
+ */
+
+#pragma once
+
+#include "../relacy/relacy.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+
+namespace rl_bench
+{
+
+
+typedef std::chrono::steady_clock bench_clock;
+
+// Returns cost of a single operation in nanoseconds,
+// 'op_total' receives number of measured operations.
+typedef double (*benchmark_f)(uint64_t& op_total);
+
+struct benchmark
+{
+    char const*     name_;
+    benchmark_f     func_;
+    benchmark*      next_;
+};
+
+inline benchmark*& benchmark_list()
+{
+    static benchmark* head = 0;
+    return head;
+}
+
+struct benchmark_registrar
+{
+    benchmark_registrar(benchmark& b, char const* name, benchmark_f func)
+    {
+        b.name_ = name;
+        b.func_ = func;
+        b.next_ = 0;
+        benchmark** pos = &benchmark_list();
+        while (*pos)
+            pos = &(*pos)->next_;
+        *pos = &b;
+    }
+};
+
+#define RL_BENCHMARK(name, func) \
+    static rl_bench::benchmark rl_bench_##name; \
+    static rl_bench::benchmark_registrar rl_bench_reg_##name (rl_bench_##name, #name, func) \
+/**/
+
+inline double elapsed_ns(bench_clock::time_point start)
+{
+    return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        bench_clock::now() - start).count();
+}
+
+// Number of operations every simulated thread executes per iteration.
+// Test suites read it from thread(), so it's changed only between simulations.
+inline unsigned& op_count()
+{
+    static unsigned count = 0;
+    return count;
+}
+
+size_t const repetition_count = 3;
+
+template<typename test_t>
+double simulation_time(rl::iteration_t iteration_count, unsigned ops, unsigned execution_depth_limit = 0)
+{
+    double best = 0;
+    for (size_t rep = 0; rep != repetition_count; ++rep)
+    {
+        rl::ostringstream stream;
+        rl::test_params params;
+        params.iteration_count = iteration_count;
+        params.output_stream = &stream;
+        params.progress_stream = &stream;
+        if (execution_depth_limit)
+            params.execution_depth_limit = execution_depth_limit;
+        op_count() = ops;
+
+        bench_clock::time_point const start = bench_clock::now();
+        bool const ok = rl::simulate<test_t>(params);
+        double const t = elapsed_ns(start);
+
+        if (false == ok)
+        {
+            std::cout << stream.str() << std::endl;
+            throw std::logic_error("benchmark test suite failed");
+        }
+
+        if (0 == rep || t < best)
+            best = t;
+    }
+    return best;
+}
+
+// Cost of the measured operation is the difference between
+// a simulation which executes 'ops' operations per thread
+// and an otherwise identical simulation which executes none.
+template<typename test_t, rl::iteration_t iteration_count = 10000, unsigned ops = 64>
+double measure_simulation(uint64_t& op_total)
+{
+    double const base = simulation_time<test_t>(iteration_count, 0);
+    double const full = simulation_time<test_t>(iteration_count, ops);
+    op_total = iteration_count * ops * test_t::params::static_thread_count;
+    double const result = (full - base) / op_total;
+    return result > 0 ? result : 0;
+}
+
+inline int run_benchmarks(int argc, char** argv)
+{
+    char const* filter = argc > 1 ? argv[1] : "";
+
+    std::printf("%-40s %12s %14s\n", "benchmark", "ns/op", "operations");
+    std::printf("%s\n", std::string(68, '-').c_str());
+
+    for (benchmark* b = benchmark_list(); b; b = b->next_)
+    {
+        if (0 == strstr(b->name_, filter))
+            continue;
+        uint64_t op_total = 0;
+        double const ns = b->func_(op_total);
+        std::printf("%-40s %12.1f %14llu\n", b->name_, ns, (unsigned long long)op_total);
+        std::fflush(stdout);
+    }
+    return 0;
+}
+
+
+}
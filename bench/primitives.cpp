@@ -0,0 +1,265 @@
+/*  Relacy Race Detector
+ *  Copyright (c) 2008-2013, Dmitry S. Vyukov
+ *  All rights reserved.
+ *  This software is provided AS-IS with no warranty, either express or implied.
+ *  This software is distributed under a license and may not be copied,
+ *  modified or distributed except as expressly authorized under the
+ *  terms of the license contained in the file LICENSE in this distribution.
+ */
+
+#include "bench.hpp"
+
+using rl_bench::op_count;
+
+
+
+template<rl::memory_order mo>
+struct atomic_load_bench : rl::test_suite<atomic_load_bench<mo>, 1>
+{
+    rl::atomic<int> x;
+    int sink;
+
+    void before()
+    {
+        x.store(0, rl::memory_order_relaxed, $);
+        sink = 0;
+    }
+
+    void thread(unsigned)
+    {
+        for (unsigned i = 0; i != op_count(); ++i)
+            sink += x.load(mo, $);
+    }
+};
+
+template<rl::memory_order mo>
+struct atomic_store_bench : rl::test_suite<atomic_store_bench<mo>, 1>
+{
+    rl::atomic<int> x;
+
+    void before()
+    {
+        x.store(0, rl::memory_order_relaxed, $);
+    }
+
+    void thread(unsigned)
+    {
+        for (unsigned i = 0; i != op_count(); ++i)
+            x.store(i, mo, $);
+    }
+};
+
+template<rl::memory_order mo>
+struct atomic_cas_bench : rl::test_suite<atomic_cas_bench<mo>, 1>
+{
+    rl::atomic<int> x;
+
+    void before()
+    {
+        x.store(0, rl::memory_order_relaxed, $);
+    }
+
+    void thread(unsigned)
+    {
+        for (unsigned i = 0; i != op_count(); ++i)
+        {
+            int cmp = i;
+            x.compare_exchange_strong(cmp, i + 1, mo, $);
+        }
+    }
+};
+
+template<rl::memory_order mo>
+struct atomic_rmw_bench : rl::test_suite<atomic_rmw_bench<mo>, 1>
+{
+    rl::atomic<int> x;
+
+    void before()
+    {
+        x.store(0, rl::memory_order_relaxed, $);
+    }
+
+    void thread(unsigned)
+    {
+        for (unsigned i = 0; i != op_count(); ++i)
+            x.fetch_add(1, mo, $);
+    }
+};
+
+struct var_load_bench : rl::test_suite<var_load_bench, 1>
+{
+    rl::var<int> x;
+    int sink;
+
+    void before()
+    {
+        VAR(x) = 0;
+        sink = 0;
+    }
+
+    void thread(unsigned)
+    {
+        for (unsigned i = 0; i != op_count(); ++i)
+            sink += VAR(x);
+    }
+};
+
+struct var_store_bench : rl::test_suite<var_store_bench, 1>
+{
+    rl::var<int> x;
+
+    void thread(unsigned)
+    {
+        for (unsigned i = 0; i != op_count(); ++i)
+            VAR(x) = i;
+    }
+};
+
+struct mutex_bench : rl::test_suite<mutex_bench, 1>
+{
+    rl::mutex mtx;
+
+    void thread(unsigned)
+    {
+        for (unsigned i = 0; i != op_count(); ++i)
+        {
+            mtx.lock($);
+            mtx.unlock($);
+        }
+    }
+};
+
+struct condvar_notify_bench : rl::test_suite<condvar_notify_bench, 1>
+{
+    rl::condition_variable cv;
+
+    void thread(unsigned)
+    {
+        for (unsigned i = 0; i != op_count(); ++i)
+            cv.notify_one($);
+    }
+};
+
+// Two threads pass the turn back and forth,
+// so every operation is a notify_one() paired with a wait().
+struct condvar_handoff_bench : rl::test_suite<condvar_handoff_bench, 2>
+{
+    rl::mutex mtx;
+    rl::condition_variable cv;
+    rl::var<unsigned> turn;
+
+    void before()
+    {
+        VAR(turn) = 0;
+    }
+
+    void thread(unsigned index)
+    {
+        for (unsigned i = 0; i != op_count(); ++i)
+        {
+            mtx.lock($);
+            while (VAR(turn) % 2 != index)
+                cv.wait(mtx, $);
+            VAR(turn) += 1;
+            cv.notify_one($);
+            mtx.unlock($);
+        }
+    }
+};
+
+
+
+struct fiber_pingpong
+{
+    fiber_t main_;
+    fiber_t fiber_;
+};
+
+static void fiber_pingpong_proc(void* ctx)
+{
+    fiber_pingpong& pp = *static_cast<fiber_pingpong*>(ctx);
+    for (;;)
+        switch_to_fiber(pp.main_, pp.fiber_);
+}
+
+double fiber_switch_bench(uint64_t& op_total)
+{
+    unsigned const round_trips = 1000000;
+    fiber_pingpong pp;
+    create_main_fiber(pp.main_);
+    create_fiber(pp.fiber_, &fiber_pingpong_proc, &pp);
+
+    rl_bench::bench_clock::time_point const start = rl_bench::bench_clock::now();
+    for (unsigned i = 0; i != round_trips; ++i)
+        switch_to_fiber(pp.fiber_, pp.main_);
+    double const t = rl_bench::elapsed_ns(start);
+
+    delete_fiber(pp.fiber_);
+    delete_main_fiber(pp.main_);
+    op_total = 2 * (uint64_t)round_trips;
+    return t / op_total;
+}
+
+template<bool defer>
+double memory_mgr_bench(uint64_t& op_total)
+{
+    unsigned const count = 1000000;
+    size_t const sizes [] = {16, 24, 64, 256};
+    size_t const size_count = sizeof(sizes) / sizeof(*sizes);
+    rl::memory_mgr mgr;
+
+    rl_bench::bench_clock::time_point const start = rl_bench::bench_clock::now();
+    for (unsigned i = 0; i != count; ++i)
+    {
+        void* p = mgr.alloc(sizes[i % size_count]);
+        mgr.free(p, defer);
+    }
+    double const t = rl_bench::elapsed_ns(start);
+
+    op_total = count;
+    return t / op_total;
+}
+
+
+
+using rl_bench::measure_simulation;
+
+RL_BENCHMARK(atomic_load_relaxed, &measure_simulation<atomic_load_bench<rl::memory_order_relaxed> >);
+RL_BENCHMARK(atomic_load_acquire, &measure_simulation<atomic_load_bench<rl::memory_order_acquire> >);
+RL_BENCHMARK(atomic_load_seq_cst, &measure_simulation<atomic_load_bench<rl::memory_order_seq_cst> >);
+
+RL_BENCHMARK(atomic_store_relaxed, &measure_simulation<atomic_store_bench<rl::memory_order_relaxed> >);
+RL_BENCHMARK(atomic_store_release, &measure_simulation<atomic_store_bench<rl::memory_order_release> >);
+RL_BENCHMARK(atomic_store_seq_cst, &measure_simulation<atomic_store_bench<rl::memory_order_seq_cst> >);
+
+RL_BENCHMARK(atomic_cas_relaxed, &measure_simulation<atomic_cas_bench<rl::memory_order_relaxed> >);
+RL_BENCHMARK(atomic_cas_acquire, &measure_simulation<atomic_cas_bench<rl::memory_order_acquire> >);
+RL_BENCHMARK(atomic_cas_release, &measure_simulation<atomic_cas_bench<rl::memory_order_release> >);
+RL_BENCHMARK(atomic_cas_acq_rel, &measure_simulation<atomic_cas_bench<rl::memory_order_acq_rel> >);
+RL_BENCHMARK(atomic_cas_seq_cst, &measure_simulation<atomic_cas_bench<rl::memory_order_seq_cst> >);
+
+RL_BENCHMARK(atomic_rmw_relaxed, &measure_simulation<atomic_rmw_bench<rl::memory_order_relaxed> >);
+RL_BENCHMARK(atomic_rmw_acquire, &measure_simulation<atomic_rmw_bench<rl::memory_order_acquire> >);
+RL_BENCHMARK(atomic_rmw_release, &measure_simulation<atomic_rmw_bench<rl::memory_order_release> >);
+RL_BENCHMARK(atomic_rmw_acq_rel, &measure_simulation<atomic_rmw_bench<rl::memory_order_acq_rel> >);
+RL_BENCHMARK(atomic_rmw_seq_cst, &measure_simulation<atomic_rmw_bench<rl::memory_order_seq_cst> >);
+
+RL_BENCHMARK(var_load, &measure_simulation<var_load_bench>);
+RL_BENCHMARK(var_store, &measure_simulation<var_store_bench>);
+
+RL_BENCHMARK(mutex_lock_unlock, &measure_simulation<mutex_bench>);
+
+RL_BENCHMARK(condvar_notify_one, &measure_simulation<condvar_notify_bench>);
+RL_BENCHMARK(condvar_notify_wait_handoff, &measure_simulation<condvar_handoff_bench>);
+
+RL_BENCHMARK(fiber_switch, &fiber_switch_bench);
+
+RL_BENCHMARK(memory_mgr_alloc_free, &memory_mgr_bench<false>);
+RL_BENCHMARK(memory_mgr_alloc_deferred_free, &memory_mgr_bench<true>);
+
+
+
+int main(int argc, char** argv)
+{
+    return rl_bench::run_benchmarks(argc, argv);
+}
@@ -0,0 +1,205 @@
+/*  Relacy Race Detector
+ *  Copyright (c) 2008-2013, Dmitry S. Vyukov
+ *  All rights reserved.
+ *  This software is provided AS-IS with no warranty, either express or implied.
+ *  This software is distributed under a license and may not be copied,
+ *  modified or distributed except as expressly authorized under the
+ *  terms of the license contained in the file LICENSE in this distribution.
+ */
+
+#include "bench.hpp"
+
+#include <cstdlib>
+
+using rl_bench::op_count;
+
+
+// Sweeps thread count and number of live synchronization objects
+// and reports how cost of a simulated iteration and of a single
+// operation grows with them.
+//
+// usage: relacy_bench_scalability [workload-filter] [max-threads] [max-objects]
+
+
+// Number of atomics/vars every test suite creates per iteration.
+inline unsigned& object_count()
+{
+    static unsigned count = 1;
+    return count;
+}
+
+
+// Acq_rel RMW on objects shared between all threads,
+// every operation acquires and releases a full vector clock.
+template<rl::thread_id_t thread_count>
+struct atomic_scale_bench : rl::test_suite<atomic_scale_bench<thread_count>, thread_count>
+{
+    rl::atomic<unsigned>* x;
+
+    void before()
+    {
+        x = new rl::atomic<unsigned> [object_count()];
+        for (unsigned i = 0; i != object_count(); ++i)
+            x[i].store(0, rl::memory_order_relaxed, $);
+    }
+
+    void after()
+    {
+        delete [] x;
+    }
+
+    void thread(unsigned index)
+    {
+        for (unsigned i = 0; i != op_count(); ++i)
+            x[(i * thread_count + index) % object_count()].fetch_add(1, rl::memory_order_acq_rel, $);
+    }
+};
+
+// Plain loads of vars initialized before threads start,
+// every operation checks the var's clock against the thread's clock.
+template<rl::thread_id_t thread_count>
+struct var_scale_bench : rl::test_suite<var_scale_bench<thread_count>, thread_count>
+{
+    rl::var<unsigned>* x;
+    unsigned sink [thread_count];
+
+    void before()
+    {
+        x = new rl::var<unsigned> [object_count()];
+        for (unsigned i = 0; i != object_count(); ++i)
+            VAR(x[i]) = i;
+    }
+
+    void after()
+    {
+        delete [] x;
+    }
+
+    void thread(unsigned index)
+    {
+        sink[index] = 0;
+        for (unsigned i = 0; i != op_count(); ++i)
+            sink[index] += VAR(x[(i * thread_count + index) % object_count()]);
+    }
+};
+
+// Relaxed store followed by a seq_cst fence,
+// every fence merges clocks of all threads.
+template<rl::thread_id_t thread_count>
+struct fence_scale_bench : rl::test_suite<fence_scale_bench<thread_count>, thread_count>
+{
+    rl::atomic<unsigned>* x;
+
+    void before()
+    {
+        x = new rl::atomic<unsigned> [object_count()];
+        for (unsigned i = 0; i != object_count(); ++i)
+            x[i].store(0, rl::memory_order_relaxed, $);
+    }
+
+    void after()
+    {
+        delete [] x;
+    }
+
+    void thread(unsigned index)
+    {
+        for (unsigned i = 0; i != op_count(); ++i)
+        {
+            x[(i * thread_count + index) % object_count()].store(i, rl::memory_order_relaxed, $);
+            rl::atomic_thread_fence(rl::memory_order_seq_cst, $);
+        }
+    }
+};
+
+
+
+unsigned const scale_min_op_count = 16;
+
+// Threads together touch every object at least once per iteration,
+// otherwise object setup cost drowns the cost of operations.
+inline unsigned scale_op_count(unsigned thread_count, unsigned objects)
+{
+    unsigned const ops = objects / thread_count;
+    return ops > scale_min_op_count ? ops : scale_min_op_count;
+}
+
+// Total amount of simulated work per measurement,
+// iteration count is derived from it so that large configurations
+// finish in reasonable time and small ones are still measurable.
+uint64_t const scale_work_budget = 4000000;
+
+inline rl::iteration_t scale_iteration_count(unsigned thread_count, unsigned objects)
+{
+    uint64_t const per_iteration = (uint64_t)thread_count * scale_op_count(thread_count, objects) + objects;
+    uint64_t count = scale_work_budget / per_iteration;
+    if (count < 10)
+        count = 10;
+    if (count > 10000)
+        count = 10000;
+    return (rl::iteration_t)count;
+}
+
+struct scale_config
+{
+    char const*     filter_;
+    unsigned        max_threads_;
+    unsigned        max_objects_;
+};
+
+template<typename test_t>
+void measure_scale(char const* workload, scale_config const& cfg)
+{
+    unsigned const thread_count = test_t::params::static_thread_count;
+    if (0 == strstr(workload, cfg.filter_) || thread_count > cfg.max_threads_)
+        return;
+
+    for (unsigned objects = 1; objects <= cfg.max_objects_; objects *= 10)
+    {
+        object_count() = objects;
+        unsigned const ops = scale_op_count(thread_count, objects);
+        rl::iteration_t const iterations = scale_iteration_count(thread_count, objects);
+        // large configurations legitimately execute more steps than
+        // default execution depth limit allows, it's not a livelock
+        unsigned const depth_limit = 4 * (thread_count * ops + objects) + 2000;
+        double const base = rl_bench::simulation_time<test_t>(iterations, 0, depth_limit);
+        double const full = rl_bench::simulation_time<test_t>(iterations, ops, depth_limit);
+        double const op_total = (double)iterations * thread_count * ops;
+        double const per_op = full > base ? (full - base) / op_total : 0;
+
+        std::printf("%-10s %8u %10u %12llu %16.1f %12.1f\n",
+            workload, thread_count, objects, (unsigned long long)iterations,
+            full / iterations, per_op);
+        std::fflush(stdout);
+    }
+}
+
+template<rl::thread_id_t thread_count>
+void sweep_workloads(scale_config const& cfg)
+{
+    measure_scale<atomic_scale_bench<thread_count> >("atomic", cfg);
+    measure_scale<var_scale_bench<thread_count> >("var", cfg);
+    measure_scale<fence_scale_bench<thread_count> >("fence", cfg);
+}
+
+
+
+int main(int argc, char** argv)
+{
+    scale_config cfg;
+    cfg.filter_ = argc > 1 ? argv[1] : "";
+    cfg.max_threads_ = argc > 2 ? (unsigned)atoi(argv[2]) : 64;
+    cfg.max_objects_ = argc > 3 ? (unsigned)atoi(argv[3]) : 100000;
+
+    std::printf("%-10s %8s %10s %12s %16s %12s\n",
+        "workload", "threads", "objects", "iterations", "ns/iteration", "ns/op");
+    std::printf("%s\n", std::string(73, '-').c_str());
+
+    sweep_workloads<2>(cfg);
+    sweep_workloads<4>(cfg);
+    sweep_workloads<8>(cfg);
+    sweep_workloads<16>(cfg);
+    sweep_workloads<32>(cfg);
+    sweep_workloads<64>(cfg);
+    return 0;
+}
@@ -434,11 +434,19 @@ private:
     bool initialized_;
     bool already_failed_;
 
+    // T is not required to have operator ==, and false negatives
+    // (padding, -0.0) only cost stale load branches (see same_value_)
+    static bool same_bits(T const& a, T const& b)
+    {
+        return 0 == memcmp(&a, &b, sizeof(T));
+    }
+
     template<memory_order mo, unsigned (thread_info::*impl)(atomic_data* RL_RESTRICT data)>
     T load_impl(debug_info_param info) const
     {
         context& c = ctx();
-        c.sched();
+        RL_STAT_SIM_SCOPE(c);
+        c.sched(info, impl_);
         sign_.check(info);
 
         if (false == c.invariant_executing)
@@ -470,13 +478,15 @@ private:
     void store_impl(T v, debug_info_param info)
     {
         context& c = ctx();
+        RL_STAT_SIM_SCOPE(c);
         RL_VERIFY(false == c.invariant_executing);
-        c.sched();
+        c.sched(info, impl_);
         sign_.check(info);
 
         unsigned const index = (c.threadx_->*impl)(impl_);
 
         T const prev = value_;
+        impl_->history_[index].same_value_ = initialized_ && same_bits(prev, v);
         last_index_ = index;
         history_[index] = v;
         value_ = v;
@@ -488,8 +498,9 @@ private:
     bool compare_swap_impl(T& cmp, T xchg, debug_info_param info)
     {
         context& c = ctx();
+        RL_STAT_SIM_SCOPE(c);
         RL_VERIFY(false == c.invariant_executing);
-        c.sched();
+        c.sched(info, impl_);
         sign_.check(info);
 
         if (false == initialized_)
@@ -527,6 +538,7 @@ private:
             {
                 success = true;
                 unsigned const index = (c.threadx_->*impl)(impl_, aba);
+                impl_->history_[index].same_value_ = same_bits(current, xchg);
                 value_ = xchg;
                 last_index_ = index;
                 history_[index] = xchg;
@@ -548,8 +560,9 @@ private:
     T rmw_impl(rmw_type_t<type>, Y op, debug_info_param info)
     {
         context& c = ctx();
+        RL_STAT_SIM_SCOPE(c);
         RL_VERIFY(false == c.invariant_executing);
-        c.sched();
+        c.sched(info, impl_);
         sign_.check(info);
 
         if (false == initialized_)
@@ -563,6 +576,7 @@ private:
 
         T const prev_value = value_;
         T const new_value = perform_rmw(rmw_type_t<type>(), prev_value, op);
+        impl_->history_[index].same_value_ = same_bits(prev_value, new_value);
         value_ = new_value;
         last_index_ = index;
         history_[index] = new_value;
@@ -60,6 +60,15 @@ T val(T x)
     return x;
 }
 
+// Mixes 'v' into hash 'h' (splitmix64 finalizer), used to hash simulation state.
+inline uint64_t hash_mix(uint64_t h, uint64_t v)
+{
+    h = (h ^ v) + 0x9e3779b97f4a7c15ull;
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+    return h ^ (h >> 31);
+}
+
 }
 
 
@@ -9,9 +9,15 @@
 
 #pragma once
 
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+
 #include "base.hpp"
 #include "context_addr_hash.hpp"
 #include "context_base.hpp"
+#include "corpus.hpp"
 #include "data/condvar_data.hpp"
 #include "data/event_data.hpp"
 #include "data/generic_mutex_data.hpp"
@@ -30,6 +36,9 @@
 #include "random_scheduler.hpp"
 #include "full_search_scheduler.hpp"
 #include "context_bound_scheduler.hpp"
+#include "delay_bound_scheduler.hpp"
+#include "hybrid_scheduler.hpp"
+#include "fuzz_scheduler.hpp"
 
 
 
@@ -93,11 +102,16 @@ private:
     iteration_t                     current_iter_;
     test_result_e                   test_result_;
     string                          test_result_str_;
+    test_failure                    failure_;
     fiber_t                         main_fiber_;
     bool                            special_function_executing;
     memory_mgr                      memory_;
     iteration_t                     start_iteration_;
+    unsigned                        start_time_;
+    bool                            time_limited_;
+    unsigned                        time_limit_;
     size_t                          sched_count_;
+    size_t                          yield_count_;
     scheduler_t                     sched_;
     shared_context_t&               sctx_;
     random_generator                rand_;
@@ -165,6 +179,9 @@ public:
         : base_t(thread_count, params)
         , current_iter_(0)
         , start_iteration_(1)
+        , start_time_(0)
+        , time_limited_(false)
+        , time_limit_(0)
         , sched_(params, sctx, dynamic_thread_count)
         , sctx_(sctx)
     {
@@ -193,6 +210,9 @@ public:
         sema_alloc_ = new slab_allocator<sema_data>();
         event_alloc_ = new slab_allocator<event_data>();
 
+        for (thread_id_t i = 0; i != static_thread_count; ++i)
+            sched_.set_symmetry_group(i, test_t::symmetry_group(i));
+
         for (thread_id_t i = 0; i != thread_count; ++i)
         {
             new (&threads_[i]) thread_info(thread_count, i);
@@ -249,6 +269,8 @@ public:
 
     virtual void* alloc(size_t size, bool is_array, debug_info_param info)
     {
+        RL_STAT_SIM_SCOPE(*this);
+        RL_STAT(params_.stats.allocs);
         disable_alloc_ += 1;
         void* p = memory_.alloc(size);
         disable_alloc_ -= 1;
@@ -258,6 +280,9 @@ public:
 
     virtual void free(void* p, bool is_array, debug_info_param info)
     {
+        RL_STAT_SIM_SCOPE(*this);
+        RL_STAT(params_.stats.frees);
+        this->set_sched_site(info);
         RL_HIST_CTX(memory_free_event) {p, is_array} RL_HIST_END();
         bool const defer = (0 == sched_.rand(this->is_random_sched() ? 4 : 2, sched_type_mem_realloc));
         disable_alloc_ += 1;
@@ -274,6 +299,8 @@ public:
         if (disable_alloc_)
             return (::malloc)(size);
 
+        RL_STAT_SIM_SCOPE(*this);
+        RL_STAT(params_.stats.allocs);
         prev_alloc_size_ = size;
         disable_alloc_ += 1;
         void* p = (memory_.alloc)(size);
@@ -301,6 +328,8 @@ public:
             return;
         }
 
+        RL_STAT_SIM_SCOPE(*this);
+        RL_STAT(params_.stats.frees);
         disable_alloc_ += 1;
         debug_info const& info = last_info_;
         RL_HIST_CTX(memory_free_event) {p, false} RL_HIST_END();
@@ -315,11 +344,13 @@ public:
                                               bool do_switch,
                                               debug_info_param info)
     {
+        RL_STAT_SIM_SCOPE(*this);
         RL_VERIFY(false == special_function_executing);
         RL_VERIFY(threadx_->saved_disable_preemption_ == -1);
         unsigned dp = disable_preemption_;
         disable_preemption_ = 0;
         RL_HIST_CTX(park_event) {is_timed, allow_spurious_wakeup} RL_HIST_END();
+        this->set_sched_site(info);
         if (false == sched_.park_current_thread(is_timed, allow_spurious_wakeup))
         {
             fail_test("deadlock detected", test_result_deadlock, info);
@@ -337,6 +368,7 @@ public:
 
     virtual void unpark_thread(thread_id_t th, bool do_switch, debug_info_param info)
     {
+        RL_STAT_SIM_SCOPE(*this);
         RL_VERIFY(false == special_function_executing);
         RL_HIST_CTX(unpark_event) {th} RL_HIST_END();
         sched_.unpark_thread(th, do_switch);
@@ -352,6 +384,7 @@ public:
     {
 //std::cout << "switching back from " << threadx_->index_ << " to " << threadx_->temp_switch_from_ << std::endl;
         (void)info;
+        RL_STAT_SIM_SCOPE(*this);
         RL_VERIFY(threadx_->saved_disable_preemption_ != -1);
         RL_VERIFY(threadx_->temp_switch_from_ != -1);
         thread_id_t const tid = threadx_->temp_switch_from_;
@@ -383,6 +416,16 @@ public:
         else
             test_result_str_ = string(test_result_str(test_result_)) + " (" + desc + ")";
 
+        // signature of the failure (collect_all_failures, minimize_schedule)
+        failure_.result = test_result_;
+        failure_.site = info;
+        for (size_t i = 0; i != failure_signature_depth; ++i)
+        {
+            failure_.recent_sites[i] = threadx_
+                ? threadx_->recent_sites_[(threadx_->recent_site_pos_ + i) % failure_signature_depth]
+                : debug_info();
+        }
+
         RL_HIST_CTX(user_event) {test_result_str_.c_str()} RL_HIST_END();
 
         switch_to_main_fiber();
@@ -408,16 +451,22 @@ public:
                 first_thread_ = false;
                 special_function_executing = true;
                 RL_HIST_CTX(user_event) {"[CTOR BEGIN]"} RL_HIST_END();
-                construct_current_test_suite();
+                {
+                    RL_STAT_USER_SCOPE(*this);
+                    construct_current_test_suite();
+                }
                 RL_HIST_CTX(user_event) {"[CTOR END]"} RL_HIST_END();
                 RL_HIST_CTX(user_event) {"[BEFORE BEGIN]"} RL_HIST_END();
-                current_test_suite->before();
+                {
+                    RL_STAT_USER_SCOPE(*this);
+                    current_test_suite->before();
+                }
                 RL_HIST_CTX(user_event) {"[BEFORE END]"} RL_HIST_END();
                 rl_global_fence();
-                invariant_executing = true;
-                current_test_suite->invariant();
-                invariant_executing = false;
+                invoke_invariant();
                 special_function_executing = false;
+                // before() is not part of the thread for failure signatures
+                param->reset_recent_sites();
             }
 
 //std::cout << "thread " << param->index_ << " started" << std::endl;
@@ -425,10 +474,12 @@ public:
 
             if (param->index_ < static_thread_count)
             {
+                RL_STAT_USER_SCOPE(*this);
                 current_test_suite->thread(param->index_);
             }
             else
             {
+                RL_STAT_USER_SCOPE(*this);
                 if (param->dynamic_thread_func_)
                     param->dynamic_thread_func_(param->dynamic_thread_param_);
             }
@@ -445,20 +496,25 @@ public:
 //std::cout << "thread " << param->index_ << " finished res=" << res << std::endl;
             if (thread_finish_result_normal == res)
             {
+                this->set_sched_site(info);
                 sched();
             }
             else if (thread_finish_result_last == res)
             {
                 special_function_executing = true;
-                invariant_executing = true;
-                current_test_suite->invariant();
-                invariant_executing = false;
+                invoke_invariant();
                 rl_global_fence();
                 RL_HIST_CTX(user_event) {"[AFTER BEGIN]"} RL_HIST_END();
-                current_test_suite->after();
+                {
+                    RL_STAT_USER_SCOPE(*this);
+                    current_test_suite->after();
+                }
                 RL_HIST_CTX(user_event) {"[AFTER END]"} RL_HIST_END();
                 RL_HIST_CTX(user_event) {"[DTOR BEGIN]"} RL_HIST_END();
-                destroy_current_test_suite();
+                {
+                    RL_STAT_USER_SCOPE(*this);
+                    destroy_current_test_suite();
+                }
                 RL_HIST_CTX(user_event) {"[DTOR END]"} RL_HIST_END();
                 special_function_executing = false;
 
@@ -500,8 +556,11 @@ public:
 
     virtual void yield(unsigned count, debug_info_param info)
     {
+        RL_STAT_SIM_SCOPE(*this);
+        RL_STAT(params_.stats.sched_calls);
         RL_VERIFY(count);
         RL_HIST_CTX(yield_event) {count} RL_HIST_END();
+        this->set_sched_site(info);
         if (sched_count_++ > params_.execution_depth_limit)
             fail_test("livelock", test_result_livelock, RL_INFO);
         schedule(count);
@@ -509,11 +568,14 @@ public:
 
     virtual void sched()
     {
+        RL_STAT_SIM_SCOPE(*this);
+        RL_STAT(params_.stats.sched_calls);
         if (sched_count_++ > params_.execution_depth_limit)
             fail_test("livelock", test_result_livelock, RL_INFO);
         if (disable_preemption_)
             return;
-        schedule(0);
+        // a thread which spins lets the others run, as if it called yield
+        schedule(threadx_->spinning_ ? 1 : 0);
     }
 
     void schedule(unsigned yield)
@@ -527,16 +589,24 @@ public:
         }
 
         special_function_executing = true;
-        invariant_executing = true;
-        current_test_suite->invariant();
-        invariant_executing = false;
+        invoke_invariant();
+        uint64_t const state = this->is_random_sched() ? 0 : state_hash(yield);
         special_function_executing = false;
 
+        // the state repeats within the execution and no thread yielded since,
+        // i.e. a spin-loop without yield
+        if (state && sched_.visit_state(state, sched_count_, yield_count_))
+            fail_test("livelock", test_result_livelock, RL_INFO);
+
         if (yield)
+        {
             threadx_->last_yield_ = threadi().own_acq_rel_order_;
+            yield_count_ += 1;
+        }
 
         unpark_reason reason = unpark_reason_normal;
         thread_id_t const th = sched_.schedule(reason, yield);
+        this->sched_object_ = 0;
         threads_[th].unpark_reason_ = reason;
 
         switch_to_fiber(th);
@@ -545,27 +615,134 @@ public:
 
     test_result_e simulate(std::ostream& ss, std::istream& sss, bool second)
     {
+        start_iteration_ = sched_.first_iteration();
         if (EOF != sss.peek())
         {
             sss >> start_iteration_;
             sched_.set_state(sss);
         }
 
+#ifdef RL_COLLECT_STATS
+        this->stat_start();
+#endif
         test_result_e const res = simulate2(second);
+#ifdef RL_COLLECT_STATS
+        this->stat_flush();
+#endif
 
         if (test_result_success != res && false == params_.collect_history)
         {
-            ss << params_.stop_iteration << " ";
-            sched_.get_state(ss);
+            ostringstream state;
+            state << params_.stop_iteration << " ";
+            sched_.get_state(state);
+            ss << state.str();
+            if (params_.collect_all_failures)
+                record_failure(state.str());
+        }
+        else if (params_.time_limit_reached || params_.search_stopped)
+        {
+            // scheduler already points to the next unexplored execution
+            ostringstream state;
+            state << params_.stop_iteration + 1 << " ";
+            sched_.get_state(state);
+            params_.final_state = state.str();
+        }
+
+        return res;
+    }
+
+    // Adds failure of the current execution to the distinct failures,
+    // and leaves in 'final_state' state which resumes the search
+    // right after the execution (empty if it was the last one).
+    void record_failure(string const& state)
+    {
+        failure_.description = test_result_str_;
+        failure_.iteration = current_iter_;
+        failure_.count = 1;
+        failure_.state = state;
+
+        rl_vector<test_failure>& failures = params_.failures;
+        size_t i = 0;
+        while (i != failures.size() && false == failures[i].same(failure_))
+            i += 1;
+        if (i == failures.size())
+            failures.push_back(failure_);
+        else
+            failures[i].count += 1;
+
+        params_.final_state.clear();
+        if (false == sched_.iteration_end())
+        {
+            ostringstream next;
+            next << current_iter_ + 1 << " ";
+            sched_.get_state(next);
+            params_.final_state = next.str();
         }
+    }
 
+    // Runs single execution of tree search scheduler: replays 'state'
+    // and then follows 'guide', decisions are recorded into 'trace'.
+    // On failure 'final_state' receives state which replays the execution.
+    test_result_e simulate_traced(std::istream& state,
+                                  schedule_trace const* guide,
+                                  schedule_trace& trace,
+                                  std::ostream& final_state,
+                                  test_failure& failure)
+    {
+        sched_.set_guide(guide, &trace);
+        test_result_e const res = replay(state, final_state);
+        failure = failure_;
+        failure.result = res;
         return res;
     }
 
+    // Runs single execution which replays 'state'.
+    // On failure 'final_state' receives state of the execution
+    // as it went (it can diverge from 'state' if allowed).
+    test_result_e replay(std::istream& state, std::ostream& final_state, bool allow_divergence = false)
+    {
+        state >> current_iter_;
+        sched_.set_state(state);
+        if (allow_divergence)
+            sched_.allow_divergence();
+        rand_.seed(current_iter_);
+        iteration(current_iter_);
+        params_.test_result = test_result_;
+        params_.stop_iteration = current_iter_;
+        if (test_result_success != test_result_)
+        {
+            final_state << current_iter_ << " ";
+            sched_.get_state(final_state);
+        }
+        return test_result_;
+    }
+
+    // Runs single execution of fuzz scheduler, decisions are taken from 'data'.
+    test_result_e fuzz(uint8_t const* data, size_t size)
+    {
+        sched_.set_input(data, size);
+        current_iter_ = 1;
+        rand_.seed(current_iter_);
+        iteration(current_iter_);
+        params_.test_result = test_result_;
+        params_.stop_iteration = current_iter_;
+        if (test_result_success != test_result_ && params_.collect_history)
+            output_history();
+        return test_result_;
+    }
+
+    virtual void get_replay_state(std::ostream& ss)
+    {
+        ss << current_iter_ << " ";
+        sched_.get_state(ss);
+    }
+
     test_result_e simulate2(bool second)
     {
         debug_info info = $;
 
+        start_time_ = get_tick_count();
+        init_time_limit();
         current_iter_ = start_iteration_;
         for (; ; ++current_iter_)
         {
@@ -577,6 +754,8 @@ public:
             {
                 params_.test_result = test_result_;
                 params_.stop_iteration = current_iter_;
+                if (params_.stop_flag)
+                    params_.stop_flag->store(true);
                 if (params_.collect_history)
                     output_history();
                 return test_result_;
@@ -593,13 +772,46 @@ public:
 
             if (sched_.iteration_end())
                 break;
+
+            if (0 == current_iter_ % time_probe_period
+                && (time_limited_ || params_.stop_flag))
+            {
+                bool const time_out = time_limited_ && get_tick_count() - start_time_ >= time_limit_;
+                bool const stopped = params_.stop_flag && params_.stop_flag->load(std::memory_order_relaxed);
+                if (time_out || stopped)
+                {
+                    params_.test_result = test_result_success;
+                    params_.stop_iteration = current_iter_;
+                    params_.time_limit_reached = time_out;
+                    params_.search_stopped = false == time_out;
+                    params_.explored_fraction = sched_.estimate_iteration_count().explored;
+                    return test_result_success;
+                }
+            }
         }
 
         params_.test_result = test_result_success;
         params_.stop_iteration = current_iter_;
+        params_.explored_fraction = 1;
         return test_result_success;
     }
 
+    void init_time_limit()
+    {
+        time_limited_ = 0 != params_.time_budget;
+        time_limit_ = params_.time_budget;
+        if (params_.deadline)
+        {
+            time_t const now = time(0);
+            time_t const remain_sec = params_.deadline > now ? params_.deadline - now : 0;
+            unsigned const remain = remain_sec < (time_t)((unsigned)-1 / 1000)
+                ? (unsigned)remain_sec * 1000 : (unsigned)-1;
+            if (false == time_limited_ || remain < time_limit_)
+                time_limit_ = remain;
+            time_limited_ = true;
+        }
+    }
+
     RL_INLINE static void reset_thread(thread_info& ti)
     {
         std::fill(ti.acquire_fence_order_.begin(), ti.acquire_fence_order_.end(), 0);
@@ -611,6 +823,9 @@ public:
         first_thread_ = true;
         disable_preemption_ = 0;
         sched_count_ = 0;
+        yield_count_ = 0;
+        this->sched_site_ = RL_INFO;
+        this->sched_object_ = 0;
 
         foreach<thread_count>(
             threads_,
@@ -640,8 +855,56 @@ public:
     }
 
 private:
+    // test_t::state_hash() combined with the state of the simulation
+    // which determines how the execution goes on: which thread is about
+    // to execute what, where other threads are stopped, which stores were made
+    // and what every thread knows about the others (vector clocks without
+    // its own time, so that a thread which spins on loads gets back
+    // to the same state). 0 if the test doesn't hash its state.
+    uint64_t state_hash(unsigned yield)
+    {
+        invariant_executing = true;
+        size_t const user = current_test_suite->state_hash();
+        invariant_executing = false;
+        if (0 == user)
+            return 0;
+
+        uint64_t h = hash_mix(user, yield);
+        h = hash_mix(h, threadx_->index_);
+        h = hash_mix(h, (uint64_t)(size_t)this->sched_object());
+        for (thread_id_t i = 0; i != thread_count; ++i)
+        {
+            thread_info const& t = threads_[i];
+            debug_info const& site = t.recent_sites_[(t.recent_site_pos_ + failure_signature_depth - 1) % failure_signature_depth];
+            h = hash_mix(h, (uint64_t)(size_t)site.file_);
+            h = hash_mix(h, site.line_);
+            h = hash_mix(h, t.store_hash_);
+            for (thread_id_t j = 0; j != thread_count; ++j)
+            {
+                if (i == j)
+                    continue;
+                h = hash_mix(h, t.acq_rel_order_[j]);
+                h = hash_mix(h, t.acquire_fence_order_[j]);
+                h = hash_mix(h, t.release_fence_order_[j]);
+            }
+            h = hash_mix(h, seq_cst_fence_order_[i]);
+        }
+        return h ? h : 1;
+    }
+
+    void invoke_invariant()
+    {
+        RL_STAT(params_.stats.invariant_calls);
+        RL_STAT_USER_SCOPE(*this);
+        invariant_executing = true;
+        current_test_suite->invariant();
+        invariant_executing = false;
+    }
+
     void switch_to_fiber(thread_id_t th)
     {
+        if (threadx_ != &threads_[th])
+            RL_STAT(params_.stats.fiber_switches);
         fiber_t& prev = threadx_ ? threadx_->fiber_ : main_fiber_;
         threadx_ = &threads_[th];
         ::switch_to_fiber(threadx_->fiber_, prev);
@@ -649,6 +912,7 @@ private:
 
     void switch_to_main_fiber()
     {
+        RL_STAT(params_.stats.fiber_switches);
         fiber_t& prev = threadx_->fiber_;
         threadx_ = 0;
         ::switch_to_fiber(main_fiber_, prev);
@@ -656,17 +920,63 @@ private:
 
     void output_progress(iteration_t iter)
     {
-        iteration_t const total = sched_.iteration_count();
-
         if (0 == iter % (progress_probe_period * 16))
         {
+            iteration_estimate const e = sched_.estimate_iteration_count();
+            double const ms_per_iteration =
+                (double)(get_tick_count() - start_time_) / (iter - start_iteration_ + 1);
+
             disable_alloc_ += 1;
-            *params_.progress_stream << iter * 100 / total << "% ("
-                << iter << "/" << total << ")" << std::endl;
+            std::ostream& s = *params_.progress_stream;
+            s << (unsigned)(e.explored * 100) << "% (" << iter << "/" << (iteration_t)(e.mean + 0.5);
+            if (e.lower != e.upper)
+            {
+                s << ", bounds " << (iteration_t)(e.lower + 0.5) << "..";
+                output_count(s, e.upper);
+            }
+            s << "), ETA ";
+            output_duration(s, (e.mean - iter) * ms_per_iteration);
+            if (e.lower != e.upper)
+            {
+                s << " (";
+                output_duration(s, (e.lower - iter) * ms_per_iteration);
+                s << "..";
+                output_duration(s, (e.upper - iter) * ms_per_iteration);
+                s << ")";
+            }
+            s << std::endl;
             disable_alloc_ -= 1;
         }
     }
 
+    static void output_count(std::ostream& s, double count)
+    {
+        if (count < 1e18)
+            s << (iteration_t)(count + 0.5);
+        else
+            s << "?";
+    }
+
+    static void output_duration(std::ostream& s, double ms)
+    {
+        if (ms < 0)
+            ms = 0;
+        if (false == (ms < 1e12))
+        {
+            s << "?";
+            return;
+        }
+        uint64_t const sec = (uint64_t)(ms / 1000);
+        if (sec >= 24 * 3600)
+            s << sec / (24 * 3600) << "d" << sec / 3600 % 24 << "h";
+        else if (sec >= 3600)
+            s << sec / 3600 << "h" << sec / 60 % 60 << "m";
+        else if (sec >= 60)
+            s << sec / 60 << "m" << sec % 60 << "s";
+        else
+            s << sec << "s";
+    }
+
     virtual unsigned rand(unsigned limit, sched_type t)
     {
         return sched_.rand(limit, t);
@@ -716,21 +1026,25 @@ private:
 
     virtual void atomic_thread_fence_acquire()
     {
+        RL_STAT_SIM_SCOPE(*this);
         threadi().atomic_thread_fence_acquire();
     }
 
     virtual void atomic_thread_fence_release()
     {
+        RL_STAT_SIM_SCOPE(*this);
         threadi().atomic_thread_fence_release();
     }
 
     virtual void atomic_thread_fence_acq_rel()
     {
+        RL_STAT_SIM_SCOPE(*this);
         threadi().atomic_thread_fence_acq_rel();
     }
 
     virtual void atomic_thread_fence_seq_cst()
     {
+        RL_STAT_SIM_SCOPE(*this);
         sched();
         threadi().atomic_thread_fence_seq_cst(seq_cst_fence_order_);
     }
@@ -863,13 +1177,224 @@ test_result_e run_test(test_params& params, std::ostream& oss, bool second)
 }
 
 
+// Replays every state of the corpus before the search, a fresh context
+// per state; the corpus can be older than the test, so replayed
+// executions may diverge from the states.
+// Returns result of the first failure, 'oss' receives its state.
+template<typename test_t, typename sched_t>
+test_result_e run_corpus(test_params& params, std::ostream& oss)
+{
+    typedef context_impl<test_t, sched_t> context_t;
+    typedef typename sched_t::shared_context_t shared_context_t;
+
+    rl_vector<string> const states = corpus_load(params);
+    for (size_t i = 0; i != states.size(); ++i)
+    {
+        shared_context_t sctx;
+        istringstream iss (states[i]);
+        test_result_e const res = context_t(params, sctx).replay(iss, oss, true);
+        if (test_result_success != res)
+        {
+            *params.output_stream << "corpus: failure reproduced by state " << i + 1
+                << " of " << states.size() << std::endl;
+            return res;
+        }
+    }
+    if (states.size())
+        *params.output_stream << "corpus: " << states.size() << " states passed" << std::endl;
+    return test_result_success;
+}
+
+// With collect_all_failures the search goes on after a failure:
+// fibers of the failed execution are abandoned, so every time
+// it's resumed in a fresh context right after the failed execution.
+// Returns result of the first failure, 'oss' receives its state.
+template<typename test_t, typename sched_t>
+test_result_e run_search(test_params& params, std::ostream& oss)
+{
+    if (false == params.collect_all_failures || params.collect_history)
+        return run_test<test_t, sched_t>(params, oss, false);
+
+    string const initial_state = params.initial_state;
+    unsigned const time_budget = params.time_budget;
+    unsigned const start_time = get_tick_count();
+    for (;;)
+    {
+        ostringstream state;
+        if (test_result_success == run_test<test_t, sched_t>(params, state, false))
+            break;
+        if (params.final_state.empty())
+        {
+            params.explored_fraction = 1;
+            break;
+        }
+        params.initial_state = params.final_state;
+        if (time_budget)
+        {
+            unsigned const spent = get_tick_count() - start_time;
+            params.time_budget = spent < time_budget ? time_budget - spent : 1;
+        }
+    }
+    params.initial_state = initial_state;
+    params.time_budget = time_budget;
+
+    if (params.failures.empty())
+        return test_result_success;
+    test_failure const& first = params.failures[0];
+    params.test_result = first.result;
+    params.stop_iteration = first.iteration;
+    oss << first.state;
+    return first.result;
+}
+
+
+template<typename test_t, typename sched_t>
+test_result_e run_traced(test_params const& params,
+                         string const& state,
+                         schedule_trace const* guide,
+                         schedule_trace& trace,
+                         string& final_state,
+                         test_failure& failure)
+{
+    typedef context_impl<test_t, sched_t> context_t;
+    typedef typename sched_t::shared_context_t shared_context_t;
+
+    ostringstream sink;
+    test_params p = params;
+    p.output_stream = &sink;
+    p.progress_stream = &sink;
+    p.collect_history = false;
+    p.output_history = false;
+    p.collect_tree_stats = false;
+    p.shard_index = 0;
+    p.shard_count = 1;
+
+    shared_context_t sctx;
+    istringstream iss (state);
+    ostringstream oss;
+    trace.clear();
+    test_result_e const res = context_t(p, sctx).simulate_traced(iss, guide, trace, oss, failure);
+    final_state = oss.str();
+    return res;
+}
+
+inline size_t count_preemptions(schedule_trace const& trace)
+{
+    size_t count = 0;
+    for (size_t i = 0; i != trace.size(); ++i)
+        count += trace[i].preemption_;
+    return count;
+}
+
+// Delta-debugs preemptions of a failing execution of tree search scheduler.
+// Removes groups of preemptions (halves, quarters, ..., single ones),
+// a removed preemption lets current thread continue while the rest of
+// the schedule is followed as close as possible (the same threads are chosen).
+// A candidate is accepted if it fails the same way (the same result,
+// failing site and last sites of the failing thread, see test_failure::same())
+// with fewer preemptions, so the result is locally minimal.
+// Updates params.final_state.
+template<typename test_t, typename sched_t>
+void minimize_schedule(test_params& params)
+{
+    size_t const replay_limit = 1000;
+    string state = params.final_state;
+    schedule_trace best;
+    string tmp;
+    test_failure target;
+    if (params.test_result != run_traced<test_t, sched_t>(params, state, 0, best, tmp, target))
+        return;
+
+    string const iter = state.substr(0, state.find(' ')) + " ";
+    size_t const initial = count_preemptions(best);
+    size_t replays = 1;
+    size_t granularity = 1;
+    schedule_trace guide;
+    schedule_trace trace;
+
+    for (;;)
+    {
+        rl_vector<size_t> preemptions;
+        for (size_t i = 0; i != best.size(); ++i)
+        {
+            if (best[i].preemption_)
+                preemptions.push_back(i);
+        }
+        if (preemptions.empty())
+            break;
+        if (granularity > preemptions.size())
+            granularity = preemptions.size();
+
+        bool reduced = false;
+        for (size_t chunk = 0; chunk != granularity && false == reduced; ++chunk)
+        {
+            size_t const begin = preemptions.size() * chunk / granularity;
+            size_t const end = preemptions.size() * (chunk + 1) / granularity;
+
+            // keep the rest of the schedule, or when removing a single
+            // preemption also try to run the rest without preemptions
+            for (int variant = 0; variant != (end - begin == 1 ? 2 : 1) && false == reduced; ++variant)
+            {
+                if (replays == replay_limit)
+                    break;
+                guide = best;
+                if (variant)
+                    guide.resize(preemptions[begin] + 1);
+                for (size_t i = begin; i != end; ++i)
+                    guide[preemptions[i]].value_ = schedule_step_continue;
+
+                replays += 1;
+                string candidate;
+                test_failure failure;
+                run_traced<test_t, sched_t>(params, iter, &guide, trace, candidate, failure);
+                if (failure.same(target) && count_preemptions(trace) < preemptions.size())
+                {
+                    best.swap(trace);
+                    state = candidate;
+                    reduced = true;
+                }
+            }
+        }
+
+        if (reduced)
+            granularity = granularity > 2 ? granularity - 1 : 1;
+        else if (granularity == preemptions.size() || replays == replay_limit)
+            break;
+        else
+            granularity *= 2;
+    }
+
+    *params.output_stream << "schedule minimized: " << initial << " -> "
+        << count_preemptions(best) << " preemptions (" << replays << " replays)" << std::endl;
+    params.final_state = state;
+}
+
+
 template<typename test_t>
-bool simulate(test_params& params)
+char const* get_test_name()
 {
     char const* test_name = typeid(test_t).name();
-		while (test_name[0] >= '0' && test_name[0] <= '9')
+    while (test_name[0] >= '0' && test_name[0] <= '9')
         test_name += 1;
-    params.test_name = test_name;
+    return test_name;
+}
+
+template<typename test_t>
+bool run_portfolio(test_params& params);
+
+template<typename test_t>
+bool simulate(test_params& params)
+{
+    if (params.portfolio.size())
+        return run_portfolio<test_t>(params);
+
+    params.test_name = get_test_name<test_t>();
+    params.stats = test_stats();
+    params.tree_stats = search_tree_stats();
+    params.time_limit_reached = false;
+    params.search_stopped = false;
+    params.explored_fraction = 0;
+    params.failures.clear();
     *params.output_stream << params.test_name << std::endl;
 
     unsigned start_time = get_tick_count();
@@ -877,14 +1402,57 @@ bool simulate(test_params& params)
     ostringstream oss;
     //istringstream iss (params.initial_state);
     test_result_e res = test_result_success;
-    if (random_scheduler_type == params.search_type)
-        res = run_test<test_t, random_scheduler<test_t::params::thread_count> >(params, oss, false);
-    else if (fair_full_search_scheduler_type == params.search_type)
-        res = run_test<test_t, full_search_scheduler<test_t::params::thread_count> >(params, oss, false);
-    else if (fair_context_bound_scheduler_type == params.search_type)
-        res = run_test<test_t, context_bound_scheduler<test_t::params::thread_count> >(params, oss, false);
-    else
-        RL_VERIFY(false);
+    if (params.corpus_dir.size())
+    {
+        if (random_scheduler_type == params.search_type)
+            res = run_corpus<test_t, random_scheduler<test_t::params::thread_count> >(params, oss);
+        else if (fair_full_search_scheduler_type == params.search_type)
+            res = run_corpus<test_t, full_search_scheduler<test_t::params::thread_count> >(params, oss);
+        else if (fair_context_bound_scheduler_type == params.search_type)
+            res = run_corpus<test_t, context_bound_scheduler<test_t::params::thread_count> >(params, oss);
+        else if (fair_delay_bound_scheduler_type == params.search_type)
+            res = run_corpus<test_t, delay_bound_scheduler<test_t::params::thread_count> >(params, oss);
+        else if (hybrid_scheduler_type == params.search_type)
+            res = run_corpus<test_t, hybrid_scheduler<test_t::params::thread_count> >(params, oss);
+        else
+            RL_VERIFY(false);
+    }
+    if (test_result_success == res)
+    {
+        if (random_scheduler_type == params.search_type)
+            res = run_search<test_t, random_scheduler<test_t::params::thread_count> >(params, oss);
+        else if (fair_full_search_scheduler_type == params.search_type)
+            res = run_search<test_t, full_search_scheduler<test_t::params::thread_count> >(params, oss);
+        else if (fair_context_bound_scheduler_type == params.search_type)
+            res = run_search<test_t, context_bound_scheduler<test_t::params::thread_count> >(params, oss);
+        else if (fair_delay_bound_scheduler_type == params.search_type)
+            res = run_search<test_t, delay_bound_scheduler<test_t::params::thread_count> >(params, oss);
+        else if (hybrid_scheduler_type == params.search_type)
+            res = run_search<test_t, hybrid_scheduler<test_t::params::thread_count> >(params, oss);
+        else
+            RL_VERIFY(false);
+
+        if (test_result_success != res && params.corpus_dir.size())
+        {
+            if (params.failures.empty())
+                corpus_add(params, oss.str());
+            for (size_t i = 0; i != params.failures.size(); ++i)
+                corpus_add(params, params.failures[i].state);
+        }
+    }
+
+    if (params.failures.size())
+    {
+        *params.output_stream << "distinct failures: " << params.failures.size() << std::endl;
+        for (size_t i = 0; i != params.failures.size(); ++i)
+            params.failures[i].output(*params.output_stream);
+        if (params.time_limit_reached)
+        {
+            *params.output_stream << "time limit reached, explored: "
+                << params.explored_fraction * 100 << "%" << std::endl;
+        }
+        *params.output_stream << std::endl;
+    }
 
     if (test_result_success == res)
     {
@@ -895,6 +1463,17 @@ bool simulate(test_params& params)
         *params.output_stream << "iterations: " << params.stop_iteration << std::endl;
         *params.output_stream << "total time: " << t << std::endl;
         *params.output_stream << "throughput: " << (uint64_t)params.stop_iteration * 1000 / t << std::endl;
+        if (params.time_limit_reached || params.search_stopped)
+        {
+            *params.output_stream << (params.time_limit_reached ? "time limit reached" : "search stopped")
+                << ", explored: " << params.explored_fraction * 100 << "%" << std::endl;
+            *params.output_stream << "final state: " << params.final_state << std::endl;
+        }
+#ifdef RL_COLLECT_STATS
+        params.stats.output(*params.output_stream, params.stop_iteration);
+#endif
+        if (params.collect_tree_stats)
+            params.tree_stats.output(*params.output_stream);
         *params.output_stream << std::endl;
     }
     else if (false == params.output_history && false == params.collect_history)
@@ -904,7 +1483,18 @@ bool simulate(test_params& params)
         //istringstream iss2 (oss.str());
         params.collect_history = true;
         params.final_state = oss.str();
+        if (params.minimize_schedule)
+        {
+            if (fair_full_search_scheduler_type == params.search_type)
+                minimize_schedule<test_t, full_search_scheduler<test_t::params::thread_count> >(params);
+            else if (fair_context_bound_scheduler_type == params.search_type)
+                minimize_schedule<test_t, context_bound_scheduler<test_t::params::thread_count> >(params);
+            params.initial_state = params.final_state;
+        }
         iteration_t const stop_iter = params.stop_iteration;
+        // stats describe the search, not the history replay
+        test_stats const stats = params.stats;
+        search_tree_stats const tree_stats = params.tree_stats;
         test_result_e res2 = test_result_success;
         if (random_scheduler_type == params.search_type)
             res2 = run_test<test_t, random_scheduler<test_t::params::thread_count> >(params, oss2, true);
@@ -912,6 +1502,10 @@ bool simulate(test_params& params)
             res2 = run_test<test_t, full_search_scheduler<test_t::params::thread_count> >(params, oss2, true);
         else if (fair_context_bound_scheduler_type == params.search_type)
             res2 = run_test<test_t, context_bound_scheduler<test_t::params::thread_count> >(params, oss2, true);
+        else if (fair_delay_bound_scheduler_type == params.search_type)
+            res2 = run_test<test_t, delay_bound_scheduler<test_t::params::thread_count> >(params, oss2, true);
+        else if (hybrid_scheduler_type == params.search_type)
+            res2 = run_test<test_t, hybrid_scheduler<test_t::params::thread_count> >(params, oss2, true);
         else
             RL_VERIFY(false);
 
@@ -924,6 +1518,8 @@ bool simulate(test_params& params)
         RL_VERIFY(params.stop_iteration == stop_iter);
         (void)stop_iter;
         (void)res2;
+        params.stats = stats;
+        params.tree_stats = tree_stats;
     }
     return test_t::params::expected_result == res;
 }
@@ -935,6 +1531,173 @@ bool simulate()
     return simulate<test_t>(params);
 }
 
+// Member of params.portfolio: "random", "full", "bound" or "bound:N"
+// (context bound N), "delay" or "delay:N" (delay bound N),
+// "hybrid" or "hybrid:D" (random prefix depth D).
+inline bool parse_portfolio_member(string const& token, test_params& p)
+{
+    size_t const colon = token.find(':');
+    string const type = token.substr(0, colon);
+    unsigned* arg = 0;
+    if (type == "random")
+        p.search_type = random_scheduler_type;
+    else if (type == "full")
+        p.search_type = fair_full_search_scheduler_type;
+    else if (type == "bound")
+    {
+        p.search_type = fair_context_bound_scheduler_type;
+        arg = &p.context_bound;
+    }
+    else if (type == "delay")
+    {
+        p.search_type = fair_delay_bound_scheduler_type;
+        arg = &p.delay_bound;
+    }
+    else if (type == "hybrid")
+    {
+        p.search_type = hybrid_scheduler_type;
+        arg = &p.hybrid_prefix_depth;
+    }
+    else
+        return false;
+    if (colon == string::npos)
+        return true;
+    unsigned long value = 0;
+    if (0 == arg || false == parse_schedule_number(token.substr(colon + 1), value))
+        return false;
+    *arg = (unsigned)value;
+    return true;
+}
+
+// Runs the test with every scheduler of params.portfolio concurrently,
+// an OS thread each, the rest of params is shared. The first failure stops other members;
+// output of the members which found a failure is printed (with history)
+// and output params are taken from the first of them.
+template<typename test_t>
+bool run_portfolio(test_params& params)
+{
+    rl_vector<test_params> members;
+    rl_vector<string> names;
+    istringstream ss (params.portfolio);
+    string token;
+    while (ss >> token)
+    {
+        test_params p = params;
+        p.portfolio.clear();
+        if (false == parse_portfolio_member(token, p))
+            throw std::logic_error("invalid portfolio member: " + std::string(token.c_str()));
+        members.push_back(p);
+        names.push_back(token);
+    }
+    if (members.empty())
+        throw std::logic_error("empty portfolio");
+
+    size_t const count = members.size();
+    std::atomic<bool> stop (false);
+    std::vector<ostringstream> outputs (count);
+    std::vector<std::exception_ptr> errors (count);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i != count; ++i)
+    {
+        members[i].output_stream = &outputs[i];
+        members[i].progress_stream = &outputs[i];
+        members[i].stop_flag = &stop;
+        threads.push_back(std::thread([&, i]()
+        {
+            try
+            {
+                simulate<test_t>(members[i]);
+            }
+            catch (...)
+            {
+                errors[i] = std::current_exception();
+                stop.store(true);
+            }
+        }));
+    }
+    for (size_t i = 0; i != count; ++i)
+        threads[i].join();
+    for (size_t i = 0; i != count; ++i)
+    {
+        if (errors[i])
+            std::rethrow_exception(errors[i]);
+    }
+
+    std::ostream& out = *params.output_stream;
+    out << get_test_name<test_t>() << std::endl;
+    size_t found = count;
+    for (size_t i = 0; i != count; ++i)
+    {
+        test_params const& p = members[i];
+        out << "portfolio " << names[i] << ": ";
+        if (test_result_success != p.test_result)
+            out << test_result_str(p.test_result);
+        else
+            out << (p.search_stopped ? "stopped" : "passed");
+        out << ", iterations: " << p.stop_iteration << std::endl;
+        if (test_result_success != p.test_result && found == count)
+            found = i;
+    }
+    out << std::endl;
+    for (size_t i = 0; i != count; ++i)
+    {
+        if (test_result_success != members[i].test_result)
+            out << "failure found by " << names[i] << ":" << std::endl << outputs[i].str();
+    }
+
+    std::ostream* const output_stream = params.output_stream;
+    std::ostream* const progress_stream = params.progress_stream;
+    std::atomic<bool>* const stop_flag = params.stop_flag;
+    string const portfolio = params.portfolio;
+    params = members[found != count ? found : 0];
+    params.output_stream = output_stream;
+    params.progress_stream = progress_stream;
+    params.stop_flag = stop_flag;
+    params.portfolio = portfolio;
+    return test_t::params::expected_result == params.test_result;
+}
+
+// Entry point for fuzzing engines, e.g. from LLVMFuzzerTestOneInput():
+//     if (false == rl::fuzz_one<my_test>(data, size)) abort();
+// Runs single execution of the test with every scheduling decision
+// taken from 'data' (see fuzz_scheduler), on failure prints its history.
+// Decisions are those of random scheduler, params.search_type is ignored.
+template<typename test_t>
+bool fuzz_one(uint8_t const* data, size_t size, test_params& params)
+{
+    typedef fuzz_scheduler<test_t::params::thread_count> sched_t;
+    typedef context_impl<test_t, sched_t> context_t;
+    typedef typename sched_t::shared_context_t shared_context_t;
+
+    params.test_name = get_test_name<test_t>();
+    params.search_type = random_scheduler_type;
+    test_result_e res = test_result_success;
+    {
+        shared_context_t sctx;
+        res = context_t(params, sctx).fuzz(data, size);
+    }
+    if (test_result_success != res && false == params.output_history && false == params.collect_history)
+    {
+        *params.output_stream << params.test_name << std::endl;
+        params.collect_history = true;
+        shared_context_t sctx;
+        test_result_e const res2 = context_t(params, sctx).fuzz(data, size);
+        params.collect_history = false;
+
+        // If you hit assert here, then probably your test is non-deterministic
+        RL_VERIFY(res == res2);
+        (void)res2;
+    }
+    return test_t::params::expected_result == res;
+}
+
+template<typename test_t>
+bool fuzz_one(uint8_t const* data, size_t size)
+{
+    test_params params;
+    return fuzz_one<test_t>(data, size, params);
+}
+
 template<void(*func)(), size_t thread_count>
 struct simulate_thunk : test_suite<simulate_thunk<func, thread_count>, 1>
 {
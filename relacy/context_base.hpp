@@ -42,6 +42,17 @@
 #   define RL_DEBUGBREAK_ON_FAILURE_IMPL
 #endif
 
+#ifdef RL_COLLECT_STATS
+#   include <chrono>
+#   define RL_STAT(counter) ((void)((counter) += 1))
+#   define RL_STAT_SIM_SCOPE(c) rl::stat_sim_scope const rl_stat_sim_scope (c)
+#   define RL_STAT_USER_SCOPE(c) rl::stat_user_scope const rl_stat_user_scope (c)
+#else
+#   define RL_STAT(counter) ((void)0)
+#   define RL_STAT_SIM_SCOPE(c) ((void)0)
+#   define RL_STAT_USER_SCOPE(c) ((void)0)
+#endif
+
 
 
 namespace rl
@@ -66,10 +77,12 @@ struct user_msg_event
 
 class context;
 
+// Context of the simulation running on the current OS thread,
+// so independent simulations can run concurrently in one process.
 template<int fake = 0>
 struct context_holder
 {
-    static context* instance_;
+    static thread_local context* instance_;
 
     static long volatile ctx_seq;
 };
@@ -117,6 +130,49 @@ public:
 
     virtual void rl_global_fence() = 0;
     virtual void sched() = 0;
+
+    // Same as sched(), but remembers the source location
+    // which the following scheduling decisions are attributed to.
+    void sched(debug_info_param info)
+    {
+        set_sched_site(info);
+        sched();
+    }
+
+    // Same as sched(info), for an operation on atomic 'object'.
+    // Tree search treats operations on different objects as independent
+    // (see test_params::partial_order_reduction).
+    void sched(debug_info_param info, void const* object)
+    {
+        set_sched_site(info);
+        if (invariant_executing)
+        {
+            sched();
+            return;
+        }
+        sched_object_ = object;
+        sched();
+        sched_object_ = 0;
+    }
+
+    void set_sched_site(debug_info_param info)
+    {
+        sched_site_ = info;
+        if (threadx_)
+            threadx_->recent_sites_[threadx_->recent_site_pos_++ % failure_signature_depth] = info;
+    }
+
+    debug_info const& sched_site() const
+    {
+        return sched_site_;
+    }
+
+    // Atomic object the operation at the current scheduling point accesses,
+    // 0 if it's something else.
+    void const* sched_object() const
+    {
+        return sched_object_;
+    }
     virtual void yield(unsigned count, debug_info_param info) = 0;
     virtual void fail_test(char const* desc, test_result_e res, debug_info_param info) = 0;
     virtual void rl_until(char const* desc, debug_info_param info) = 0;
@@ -201,16 +257,99 @@ public:
     {
     }
 
+    test_stats& stats()
+    {
+        return params_.stats;
+    }
+
+    test_params& params()
+    {
+        return params_;
+    }
+
+    // Writes state of the current execution in initial_state format,
+    // so that the execution can be replayed up to the current point.
+    virtual void get_replay_state(std::ostream& ss) = 0;
+
+#ifdef RL_COLLECT_STATS
+    // Wall time is attributed to user code while current thread
+    // executes test suite code and not a simulated primitive called from it.
+    bool stat_in_user() const
+    {
+        return threadx_ && threadx_->stat_user_depth_ && 0 == threadx_->stat_sim_depth_;
+    }
+
+    static uint64_t stat_now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void stat_start()
+    {
+        stat_mark_ = stat_now();
+    }
+
+    void stat_flush()
+    {
+        uint64_t const now = stat_now();
+        if (stat_in_user())
+            params_.stats.user_time += now - stat_mark_;
+        else
+            params_.stats.simulator_time += now - stat_mark_;
+        stat_mark_ = now;
+    }
+
+    void stat_enter_sim()
+    {
+        if (stat_in_user())
+            stat_flush();
+        if (threadx_)
+            threadx_->stat_sim_depth_ += 1;
+    }
+
+    void stat_leave_sim()
+    {
+        if (threadx_)
+        {
+            if (threadx_->stat_user_depth_ && 1 == threadx_->stat_sim_depth_)
+                stat_flush();
+            threadx_->stat_sim_depth_ -= 1;
+        }
+    }
+
+    unsigned stat_enter_user()
+    {
+        stat_flush();
+        unsigned const depth = threadx_->stat_sim_depth_;
+        threadx_->stat_sim_depth_ = 0;
+        threadx_->stat_user_depth_ += 1;
+        return depth;
+    }
+
+    void stat_leave_user(unsigned sim_depth)
+    {
+        stat_flush();
+        threadx_->stat_sim_depth_ = sim_depth;
+        threadx_->stat_user_depth_ -= 1;
+    }
+#endif
+
 protected:
     history_mgr history_;
     test_params& params_;
     unsigned disable_preemption_;
     int                         disable_alloc_;
+    uint64_t                    stat_mark_;
+    debug_info                  sched_site_;
+    void const*                 sched_object_;
 
     context(thread_id_t thread_count, test_params& params)
         : history_(*params.output_stream, thread_count)
         , params_(params)
         , disable_alloc_(1)
+        , stat_mark_(0)
+        , sched_object_(0)
     {
         RL_VERIFY(0 == context_holder<>::instance_);
         context_holder<>::instance_ = this;
@@ -245,7 +384,7 @@ void context::exec_log(debug_info_param info, event_t const& ev)
 }
 
 template<int fake>
-context* context_holder<fake>::instance_ = 0;
+thread_local context* context_holder<fake>::instance_ = 0;
 
 
 
@@ -275,6 +414,51 @@ inline void set_errno(int value)
     return ctx().set_errno(value);
 }
 
+#ifdef RL_COLLECT_STATS
+class stat_sim_scope
+{
+public:
+    stat_sim_scope(context& c)
+        : c_(c)
+    {
+        c_.stat_enter_sim();
+    }
+
+    stat_sim_scope(const stat_sim_scope &) = delete;
+    stat_sim_scope &operator=(const stat_sim_scope &) = delete;
+
+    ~stat_sim_scope()
+    {
+        c_.stat_leave_sim();
+    }
+
+private:
+    context& c_;
+};
+
+class stat_user_scope
+{
+public:
+    stat_user_scope(context& c)
+        : c_(c)
+        , sim_depth_(c.stat_enter_user())
+    {
+    }
+
+    stat_user_scope(const stat_user_scope &) = delete;
+    stat_user_scope &operator=(const stat_user_scope &) = delete;
+
+    ~stat_user_scope()
+    {
+        c_.stat_leave_user(sim_depth_);
+    }
+
+private:
+    context& c_;
+    unsigned const sim_depth_;
+};
+#endif
+
 class preemption_disabler
 {
 public:
@@ -302,6 +486,7 @@ private:
 
 #define RL_HIST_IMPL(C, INFO, TYPE) \
     do { \
+        RL_STAT(C.stats().history_events); \
         if (C.collecting_history()) { \
             rl::debug_info const& rl_info_c = INFO; \
             rl::context& rl_hist_c = C; \
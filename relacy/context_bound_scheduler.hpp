@@ -79,46 +79,9 @@ public:
         }
     }
 
-    double iteration_count_approx()
+    unsigned search_state() const
     {
-        return 1.0;
-        /*
-        iteration_t const P = thread_count;
-        iteration_t const C0 = this->params_.context_bound;
-        iteration_t total = 1;//factorial(P);// * power(P, P * C0);
-        for (iteration_t i = 0; i != P - 1; ++i)
-            total *= power(i + 1, C0 + 1);
-        //if (C0)
-        //    total *= power(P - 1, P - 1);
-        if (val(P) > 1)
-        {
-            for (iteration_t i = 0; i != P; ++i)
-            {
-                iteration_t const N = this->threads_[i].sched_count_;
-                iteration_t const C = C0 + this->threads_[i].forced_context_switch_count_;
-                //total *= (iteration_t)pow((double)(threads_[i].sched_count_ + 2) * (thread_count - 1), (int)(params_.context_bound + threads_[i].forced_context_switch_count_));
-                total *= factorial(N, C) / factorial(C);
-                //C$ += C + 1;
-                //total *= (int)(params_.context_bound + threads_[i].forced_context_switch_count_));
-            }
-            //total *= factorial(C$);
-        }
-        else
-        {
-            total = 1;
-        }
-        //iteration_t total = (iteration_t)pow((double)sched_count / thread_count + 1, (int)(params_.context_bound * thread_count + forced_context_switch_mean_ + 0.5));
-        //total *= thread_count;
-        //total *= (iteration_t)pow((double)thread_count - 1, thread_count);
-        for (size_t i = 0; i != this->stree_.size(); ++i)
-        {
-            if (this->stree_[i].type_ != sched_type_sched)
-            {
-                total *= this->stree_[i].count_;
-            }
-        }
-        return (double)total;
-        */
+        return switches_remain_;
     }
 
 private:
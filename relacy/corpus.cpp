@@ -0,0 +1,63 @@
+/*  Relacy Race Detector
+ *  Copyright (c) 2008-2013, Dmitry S. Vyukov
+ *  All rights reserved.
+ *  This software is provided AS-IS with no warranty, either express or implied.
+ *  This software is distributed under a license and may not be copied,
+ *  modified or distributed except as expressly authorized under the
+ *  terms of the license contained in the file LICENSE in this distribution.
+ */
+
+#include "corpus.hpp"
+
+#include <fstream>
+
+namespace rl
+{
+
+static char const* const corpus_sched_names [sched_count] = {"random", "bound", "full", "delay", "hybrid"};
+
+string corpus_path(test_params const& params)
+{
+    string path = params.corpus_dir;
+    if (path.size() && path[path.size() - 1] != '/')
+        path += '/';
+    // test names are type names, keep them file name friendly
+    for (size_t i = 0; i != params.test_name.size(); ++i)
+    {
+        char const c = params.test_name[i];
+        bool const plain = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+            || (c >= '0' && c <= '9') || c == '_';
+        path += plain ? c : '_';
+    }
+    path += '.';
+    path += corpus_sched_names[params.search_type];
+    return path;
+}
+
+rl_vector<string> corpus_load(test_params const& params)
+{
+    rl_vector<string> states;
+    std::ifstream file (corpus_path(params).c_str());
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (line.size())
+            states.push_back(string(line.c_str()));
+    }
+    return states;
+}
+
+void corpus_add(test_params const& params, string const& state)
+{
+    if (state.empty())
+        return;
+    rl_vector<string> const states = corpus_load(params);
+    if (states.end() != std::find(states.begin(), states.end(), state))
+        return;
+    std::ofstream file (corpus_path(params).c_str(), std::ios::app);
+    file << state << std::endl;
+    if (false == file.good())
+        *params.output_stream << "failed to write corpus file " << corpus_path(params) << std::endl;
+}
+
+}
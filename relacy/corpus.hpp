@@ -0,0 +1,28 @@
+/*  Relacy Race Detector
+ *  Copyright (c) 2008-2013, Dmitry S. Vyukov
+ *  All rights reserved.
+ *  This software is provided AS-IS with no warranty, either express or implied.
+ *  This software is distributed under a license and may not be copied,
+ *  modified or distributed except as expressly authorized under the
+ *  terms of the license contained in the file LICENSE in this distribution.
+ */
+
+#pragma once
+
+#include "base.hpp"
+#include "test_params.hpp"
+
+namespace rl
+{
+
+// Regression corpus: states of failed executions found so far,
+// one file per test and scheduler type in params.corpus_dir,
+// one state (in initial_state format) per line.
+string corpus_path(test_params const& params);
+
+rl_vector<string> corpus_load(test_params const& params);
+
+// Appends 'state' unless the corpus already holds it.
+void corpus_add(test_params const& params, string const& state);
+
+}
@@ -31,6 +31,7 @@ atomic_data::atomic_data(thread_id_t thread_count)
 
     rec.busy_ = false;
     rec.seq_cst_ = false;
+    rec.same_value_ = false;
     rec.thread_id_ = (thread_id_t)-1;
 }
 
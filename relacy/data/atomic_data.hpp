@@ -27,6 +27,7 @@ struct atomic_data
 
         bool busy_;
         bool seq_cst_;
+        bool same_value_;   // stored the value of the previous record
         thread_id_t thread_id_;
         timestamp_t acq_rel_timestamp_;
     };
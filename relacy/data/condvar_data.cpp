@@ -29,7 +29,7 @@ void condvar_data::notify_one(debug_info_param info)
 {
     context& c = ctx();
     //??? do I need this scheduler call?
-    c.sched();
+    c.sched(info);
     sign_.check(info);
     RL_HIST(event_t) {this, event_t::type_notify_one, ws_.size()} RL_HIST_END();
     ws_.unpark_one(c, info);
@@ -39,7 +39,7 @@ void condvar_data::notify_all(debug_info_param info)
 {
     context& c = ctx();
     //??? do I need this scheduler call?
-    c.sched();
+    c.sched(info);
     sign_.check(info);
     RL_HIST(event_t) {this, event_t::type_notify_all, ws_.size()} RL_HIST_END();
     ws_.unpark_all(c, info);
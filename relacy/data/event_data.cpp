@@ -28,7 +28,7 @@ event_data::~event_data()
 void event_data::set(debug_info_param info)
 {
     context& c = ctx();
-    c.sched();
+    c.sched(info);
     sign_.check(info);
 
     bool initial_state = state_;
@@ -61,7 +61,7 @@ void event_data::set(debug_info_param info)
 void event_data::reset(debug_info_param info)
 {
     context& c = ctx();
-    c.sched();
+    c.sched(info);
     sign_.check(info);
 
     bool initial_state = state_;
@@ -79,7 +79,7 @@ void event_data::reset(debug_info_param info)
 void event_data::pulse(debug_info_param info)
 {
     context& c = ctx();
-    c.sched();
+    c.sched(info);
     sign_.check(info);
 
     //??? should I model nasty caveat described in MSDN
@@ -104,7 +104,7 @@ void event_data::pulse(debug_info_param info)
 sema_wakeup_reason event_data::wait(bool try_wait, bool is_timed, debug_info_param info)
 {
     context& c = ctx();
-    c.sched();
+    c.sched(info);
     sign_.check(info);
 
     bool initial_state = state_;
@@ -72,7 +72,7 @@ generic_mutex_data::~generic_mutex_data()
 bool generic_mutex_data::lock_exclusive(bool is_timed, debug_info_param info)
 {
     context& c = ctx();
-    c.sched();
+    c.sched(info);
     sign_.check(info);
     RL_VERIFY(false == c.invariant_executing);
 
@@ -131,7 +131,7 @@ bool generic_mutex_data::lock_exclusive(bool is_timed, debug_info_param info)
 bool generic_mutex_data::try_lock_exclusive(debug_info_param info)
 {
     context& c = ctx();
-    c.sched();
+    c.sched(info);
     sign_.check(info);
     RL_VERIFY(false == c.invariant_executing);
 
@@ -192,7 +192,7 @@ bool generic_mutex_data::try_lock_exclusive(debug_info_param info)
 void generic_mutex_data::unlock_exclusive(debug_info_param info)
 {
     context& c = ctx();
-    c.sched();
+    c.sched(info);
     sign_.check(info);
     RL_VERIFY(false == c.invariant_executing);
 
@@ -226,7 +226,7 @@ void generic_mutex_data::lock_shared(debug_info_param info)
 {
     RL_VERIFY(is_rw_);
     context& c = ctx();
-    c.sched();
+    c.sched(info);
     sign_.check(info);
     RL_VERIFY(false == c.invariant_executing);
 
@@ -282,7 +282,7 @@ bool generic_mutex_data::try_lock_shared(debug_info_param info)
 {
     RL_VERIFY(is_rw_);
     context& c = ctx();
-    c.sched();
+    c.sched(info);
     sign_.check(info);
     RL_VERIFY(false == c.invariant_executing);
 
@@ -344,7 +344,7 @@ void generic_mutex_data::unlock_shared(debug_info_param info)
 {
     RL_VERIFY(is_rw_);
     context& c = ctx();
-    c.sched();
+    c.sched(info);
     sign_.check(info);
     RL_VERIFY(false == c.invariant_executing);
 
@@ -80,7 +80,7 @@ sema_wakeup_reason sema_data::wait(
     debug_info_param info)
 {
     context& c = ctx();
-    c.sched();
+    c.sched(info);
     sign_.check(info);
 
     sema_wakeup_reason reason = sema_wakeup_reason_success;
@@ -135,7 +135,7 @@ sema_wakeup_reason sema_data::wait(
 bool sema_data::post(unsigned count, unsigned& prev_count, debug_info_param info)
 {
     context& c = ctx();
-    c.sched();
+    c.sched(info);
     sign_.check(info);
 
     bool result = false;
@@ -164,7 +164,7 @@ bool sema_data::post(unsigned count, unsigned& prev_count, debug_info_param info
 int sema_data::get_value(debug_info_param info)
 {
     context& c = ctx();
-    c.sched();
+    c.sched(info);
     sign_.check(info);
 
     RL_VERIFY(count_ <= INT_MAX);
@@ -38,6 +38,17 @@ void thread_info::iteration_begin()
     acq_rel_order_[index_] = 1;
     temp_switch_from_ = -1;
     saved_disable_preemption_ = -1;
+    stat_user_depth_ = 0;
+    stat_sim_depth_ = 0;
+    store_hash_ = 0;
+    reset_spin();
+    reset_recent_sites();
+}
+
+void thread_info::reset_recent_sites()
+{
+    std::fill(recent_sites_, recent_sites_ + failure_signature_depth, debug_info());
+    recent_site_pos_ = 0;
 }
 
 void thread_info::on_start()
@@ -62,6 +73,7 @@ unsigned thread_info::thread_info::atomic_init(atomic_data* RL_RESTRICT data)
     rec.busy_ = true;
     rec.thread_id_ = index_;
     rec.seq_cst_ = false;
+    rec.same_value_ = false;
     rec.acq_rel_timestamp_ = 0;
 
     std::fill(
@@ -181,6 +193,23 @@ unsigned thread_info::atomic_rmw_seq_cst(atomic_data* RL_RESTRICT data, bool& ab
     return atomic_rmw<memory_order_seq_cst>(data, aba);
 }
 
+// Loading 'prev' instead of the next record 'rec' is not worth a branch
+// if 'rec' stored the same value, carries no synchronization 'prev' doesn't,
+// and both give the loading thread the same clock ('order').
+static bool same_load_outcome(history_t const& rec, history_t const& prev, timestamp_t const* order)
+{
+    if (false == rec.same_value_)
+        return false;
+    for (size_t i = 0; i != rec.acq_rel_order_.size(); ++i)
+    {
+        timestamp_t const r = rec.acq_rel_order_[i];
+        timestamp_t const p = prev.acq_rel_order_[i];
+        if (r > p || (p > order[i] && p != r))
+            return false;
+    }
+    return true;
+}
+
 template<memory_order mo, bool rmw>
 unsigned thread_info::get_load_index(atomic_data& var)
 {
@@ -192,6 +221,7 @@ unsigned thread_info::get_load_index(atomic_data& var)
         size_t const limit = c.is_random_sched() ? atomic_history_size  - 1: 1;
         for (size_t i = 0; i != limit; ++i, --index)
         {
+            RL_STAT(c.stats().load_index_steps);
             history_t const& rec = var.history_[index % atomic_history_size];
             if (false == rec.busy_)
                 return (unsigned)-1; // access to unitialized var
@@ -222,6 +252,17 @@ unsigned thread_info::get_load_index(atomic_data& var)
             if (stop)
                 break;
 
+            // random scheduler keeps its decisions (and so reproducibility of iterations)
+            if (false == c.is_random_sched())
+            {
+                bool const synch =
+                    (memory_order_acquire == mo
+                    || memory_order_acq_rel == mo
+                    || memory_order_seq_cst == mo);
+                if (same_load_outcome(rec, prev, synch ? &acq_rel_order_[0] : &acquire_fence_order_[0]))
+                    break;
+            }
+
             if (0 == c.rand(2, sched_type_atomic_load))
                 break;
         }
@@ -233,6 +274,24 @@ unsigned thread_info::get_load_index(atomic_data& var)
     return index;
 }
 
+void thread_info::on_spin_load(atomic_data const* data, unsigned index, debug_info const& site)
+{
+    for (unsigned i = 0; i != spin_load_count_; ++i)
+    {
+        spin_load const& l = spin_loads_[i];
+        if (l.data_ == data && l.index_ == index && l.line_ == site.line_ && l.file_ == site.file_)
+        {
+            spinning_ = true;
+            return;
+        }
+    }
+    spinning_ = false;
+    if (spin_load_count_ == spin_loop_window)
+        spin_load_count_ = 0;
+    spin_load const l = {data, index, site.file_, site.line_};
+    spin_loads_[spin_load_count_++] = l;
+}
+
 template<memory_order mo, bool rmw>
 unsigned thread_info::atomic_load(atomic_data* RL_RESTRICT data)
 {
@@ -243,6 +302,10 @@ unsigned thread_info::atomic_load(atomic_data* RL_RESTRICT data)
     if ((unsigned)-1 == index)
         return (unsigned)-1;
 
+    context& c = ctx();
+    if (c.params().detect_spin_loops)
+        on_spin_load(data, index, c.sched_site());
+
     index %= atomic_history_size;
     history_t& rec = data->history_[index];
     RL_VERIFY(rec.busy_);
@@ -297,10 +360,13 @@ unsigned thread_info::atomic_store(atomic_data* RL_RESTRICT data)
 
     unsigned const idx = ++data->current_index_ % atomic_history_size;
     history_t& rec = data->history_[idx];
+    store_hash_ += hash_mix((uint64_t)(size_t)data, data->current_index_);
+    reset_spin();
 
     rec.busy_ = true;
     rec.thread_id_ = index_;
     rec.seq_cst_ = (memory_order_seq_cst == mo);
+    rec.same_value_ = false;
 
     own_acq_rel_order_ += 1;
     rec.acq_rel_timestamp_ = own_acq_rel_order_;
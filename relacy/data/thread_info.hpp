@@ -29,6 +29,8 @@ struct thread_info
 
     void iteration_begin();
 
+    void reset_recent_sites();
+
     void on_start();
 
     void on_finish();
@@ -90,8 +92,38 @@ struct thread_info
     thread_sync_object sync_object_;
     rl_vector<timestamp_t> acquire_fence_order_;
     rl_vector<timestamp_t> release_fence_order_;
+    // user/simulator time accounting (RL_COLLECT_STATS)
+    unsigned stat_user_depth_;
+    unsigned stat_sim_depth_;
+    // ring of the last scheduling sites of the thread (collect_all_failures)
+    debug_info recent_sites_ [failure_signature_depth];
+    unsigned recent_site_pos_;
+    // sum of hashes of atomic stores made by the thread (state hashing)
+    uint64_t store_hash_;
+    // atomic loads since the last store of the thread, a repeated one
+    // (the same site, variable and store) means that the thread spins
+    // and yields at every scheduling point until it sees something new
+    // (detect_spin_loops)
+    struct spin_load
+    {
+        atomic_data const* data_;
+        unsigned index_;
+        char const* file_;
+        unsigned line_;
+    };
+    spin_load spin_loads_ [spin_loop_window];
+    unsigned spin_load_count_;
+    bool spinning_;
+
+    void reset_spin()
+    {
+        spin_load_count_ = 0;
+        spinning_ = false;
+    }
 
 private:
+    void on_spin_load(atomic_data const* data, unsigned index, debug_info const& site);
+
     template<memory_order mo, bool rmw>
     unsigned get_load_index(atomic_data& var);
 
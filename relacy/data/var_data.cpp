@@ -37,6 +37,7 @@ bool var_data::store(thread_info& th)
 
     th.own_acq_rel_order_ += 1;
     store_acq_rel_timestamp_[th.index_] = th.own_acq_rel_order_;
+    th.reset_spin();
     return true;
 }
 
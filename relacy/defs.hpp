@@ -29,6 +29,9 @@ typedef uint64_t iteration_t;
 
 size_t const atomic_history_size = 3;
 iteration_t const progress_probe_period = 4 * 1024;
+iteration_t const time_probe_period = 16;
+size_t const failure_signature_depth = 4;
+size_t const spin_loop_window = 8;
 
 size_t const alignment = 16;
 
@@ -43,6 +46,7 @@ enum sched_type
     sched_type_cas_fail,
     sched_type_mem_realloc,
     sched_type_user,
+    sched_type_count,
 };
 
 enum unpark_reason
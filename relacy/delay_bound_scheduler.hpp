@@ -0,0 +1,94 @@
+/*  Relacy Race Detector
+ *  Copyright (c) 2008-2013, Dmitry S. Vyukov
+ *  All rights reserved.
+ *  This software is provided AS-IS with no warranty, either express or implied.
+ *  This software is distributed under a license and may not be copied,
+ *  modified or distributed except as expressly authorized under the
+ *  terms of the license contained in the file LICENSE in this distribution.
+ */
+
+#pragma once
+
+#include "base.hpp"
+#include "full_search_scheduler.hpp"
+
+
+namespace rl
+{
+
+
+// Delay bounding (Emmi, Qadeer, Rakamaric, "Delay-bounded scheduling").
+// The deterministic schedule is non-preemptive round-robin: current thread
+// runs until it blocks, yields or finishes, then the next running thread
+// by index gets control. A delay skips the thread round-robin would pick
+// in favour of the next one, an execution has at most delay_bound delays.
+// Unlike context bound the number of choices at a scheduling point
+// doesn't grow with the number of threads, so the number of executions
+// is polynomial in thread count for a fixed bound.
+template<thread_id_t thread_count>
+class delay_bound_scheduler
+    : public tree_search_scheduler<delay_bound_scheduler<thread_count>
+        , tree_search_scheduler_thread_info<thread_count>, thread_count>
+{
+public:
+    typedef tree_search_scheduler<delay_bound_scheduler<thread_count>
+        , tree_search_scheduler_thread_info<thread_count>, thread_count> base_t;
+    typedef typename base_t::thread_info_t thread_info_t;
+    typedef typename base_t::shared_context_t shared_context_t;
+
+    delay_bound_scheduler(test_params& params, shared_context_t& ctx, thread_id_t dynamic_thread_count)
+        : base_t(params, ctx, dynamic_thread_count)
+    {
+    }
+
+    delay_bound_scheduler(const delay_bound_scheduler &) = delete;
+    delay_bound_scheduler &operator=(const delay_bound_scheduler &) = delete;
+
+    thread_id_t iteration_begin_impl()
+    {
+        delays_remain_ = this->params_.delay_bound;
+        return base_t::iteration_begin_impl();
+    }
+
+    // without delays left current thread keeps running
+    bool can_switch(thread_info_t& /*t*/)
+    {
+        return delays_remain_ != 0;
+    }
+
+    void on_switch(thread_info_t& /*t*/)
+    {
+    }
+
+    // Branch i of the decision is round-robin order with i delays.
+    thread_id_t select_thread(thread_info_t const* current)
+    {
+        thread_id_t const start = current ? current->index_ : 0;
+        thread_id_t order [thread_count];
+        unsigned count = 0;
+        for (thread_id_t i = 0; i != thread_count; ++i)
+        {
+            thread_id_t const th = (start + i) % thread_count;
+            if (this->threads_[th].state_ == thread_state_running
+                && false == this->symmetric_duplicate(th))
+                order[count++] = th;
+        }
+        RL_VERIFY(count);
+
+        unsigned const limit = count - 1 < delays_remain_ ? count : delays_remain_ + 1;
+        unsigned const delays = limit > 1 ? this->rand(limit, sched_type_sched) : 0;
+        delays_remain_ -= delays;
+        return order[delays];
+    }
+
+    unsigned search_state() const
+    {
+        return delays_remain_;
+    }
+
+private:
+    unsigned delays_remain_;
+};
+
+
+}
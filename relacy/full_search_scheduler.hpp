@@ -9,6 +9,9 @@
 
 #pragma once
 
+#include <math.h>
+#include <stdexcept>
+
 #include "base.hpp"
 #include "scheduler.hpp"
 #include "foreach.hpp"
@@ -18,17 +21,72 @@ namespace rl
 {
 
 
+// One decision of a traced execution (see schedule minimization in simulate()).
+// For thread switches 'value_' is the thread which was chosen,
+// for other decisions it's the branch index.
+// 'thread_' is the thread which made the decision (-1 at iteration start).
+struct schedule_step
+{
+    sched_type                  type_;
+    unsigned                    value_;
+    thread_id_t                 thread_;
+    bool                        preemption_;
+};
+
+typedef rl_vector<schedule_step> schedule_trace;
+
+// Guide value which asks to keep running current thread.
+unsigned const schedule_step_continue = (unsigned)-1;
+
+
+// Step of test_params::schedule_script: 'thread_' runs (whenever it's runnable)
+// until it reaches scheduling point at 'site_', or until it finishes if site line is 0.
+struct script_step
+{
+    thread_id_t                 thread_;
+    schedule_site               site_;
+};
+
+// Script is a list of steps separated by spaces: "1@queue.hpp:42 0"
+// makes thread 1 run until it's about to execute operation at line 42
+// of queue.hpp, then thread 0 run to completion, the rest is explored as usual.
+inline rl_vector<script_step> parse_schedule_script(string const& script, thread_id_t thread_count)
+{
+    rl_vector<script_step> steps;
+    istringstream ss (script);
+    string token;
+    while (ss >> token)
+    {
+        size_t const at = token.find('@');
+        unsigned long thread = 0;
+        script_step step = {0, {string(), 0}};
+        bool valid = parse_schedule_number(token.substr(0, at), thread) && thread < (unsigned long)thread_count;
+        if (valid && at != string::npos)
+            valid = step.site_.parse(token.substr(at + 1));
+        if (false == valid)
+            throw std::logic_error("invalid schedule script step: " + std::string(token.c_str()));
+        step.thread_ = (thread_id_t)thread;
+        steps.push_back(step);
+    }
+    return steps;
+}
+
+
+
+
 template<thread_id_t thread_count>
 struct tree_search_scheduler_thread_info : scheduler_thread_info
 {
     unsigned                    yield_sched_count_ [thread_count];
     unsigned                    yield_priority_ [thread_count];
     unsigned                    total_yield_priority_;
+    bool                        started_;   // reached a scheduling point
     //unsigned                    subsequent_timed_waits_;
 
     void reset(test_params& params)
     {
         scheduler_thread_info::reset(params);
+        started_ = false;
         foreach<thread_count>(yield_sched_count_, &assign_zero_u);
         foreach<thread_count>(yield_priority_, &assign_zero_u);
         total_yield_priority_ = 0;
@@ -55,8 +113,23 @@ public:
     tree_search_scheduler(test_params& params, shared_context_t& ctx, thread_id_t dynamic_thread_count)
         : base_t(params, ctx, dynamic_thread_count)
         , stree_depth_()
-        , iteration_count_mean_()
-        , iteration_count_probe_count_()
+        , shard_mass_()
+        , shard_split_depth_()
+        , guide_()
+        , trace_()
+        , candidates_()
+        , divergence_allowed_()
+        , script_(parse_schedule_script(params.schedule_script, thread_count))
+        , script_pos_()
+        , por_(params.partial_order_reduction && derived_t::supports_sleep_sets && thread_count <= 64)
+        , sleep_()
+        , next_skip_()
+        , redundant_()
+        , explored_initial_()
+        , sample_weight_()
+        , sample_weight_sq_()
+        , sample_value_()
+        , sample_count_()
     {
         stree_.reserve(128);
     }
@@ -67,23 +140,46 @@ public:
     thread_id_t iteration_begin_impl()
     {
         stree_depth_ = 0;
+        shard_mass_ = 1;
+        shard_split_depth_ = no_split;
+        script_pos_ = 0;
+        sleep_ = 0;
+        next_skip_ = 0;
+        redundant_ = false;
+        for (thread_id_t i = 0; i != thread_count; ++i)
+            pending_[i] = 0;
+
+        thread_id_t const scripted = script_thread(0);
+        if ((thread_id_t)-1 != scripted)
+            return scripted;
 
-        unsigned const index = rand_impl(this->running_threads_count, sched_type_sched);
-        thread_id_t const th = this->running_threads[index];
-        return th;
+        return self().select_thread(0);
     }
 
     bool iteration_end_impl()
     {
         RL_VERIFY(stree_depth_ == stree_.size());
 
+        if (this->params_.collect_tree_stats)
+            this->params_.tree_stats.add_path(stree_depth_);
+
+        double weight = 1;
+        for (size_t i = 0; i != stree_.size(); ++i)
+            weight /= stree_[i].count_;
+        sample_weight_ += weight;
+        sample_weight_sq_ += weight * weight;
+        sample_value_ += 1 / weight;
+        sample_count_ += 1;
+
+        bool const owned = shard_path_owned();
         for (size_t i = stree_.size(); i != 0; --i)
         {
             stree_node& n = stree_[i - 1];
-            if (n.index_ != n.count_ - 1)
+            unsigned const next = next_branch(i - 1, n.index_, owned);
+            if (next != n.count_)
             {
                 stree_.resize(i);
-                n.index_ += 1;
+                n.index_ = next;
                 RL_VERIFY(n.index_ < n.count_);
                 return false;
             }
@@ -122,6 +218,9 @@ public:
     {
         thread_info_t& t = *this->thread_;
         thread_id_t const& running_thread_count = this->running_threads_count;
+        t.started_ = true;
+        if (por_)
+            pending_[t.index_] = ctx().sched_object();
 
 #ifdef _DEBUG
         {
@@ -155,8 +254,13 @@ public:
 
         reason = unpark_reason_normal;
         thread_id_t thread_index = 0;
+        thread_id_t const scripted = script_thread(&t);
 
-        if (self().can_switch(t)
+        if ((thread_id_t)-1 != scripted)
+        {
+            thread_index = scripted;
+        }
+        else if (self().can_switch(t)
             || t.state_ != thread_state_running)
         {
             thread_id_t timed_thread_count = this->timed_thread_count_;
@@ -212,17 +316,7 @@ public:
             }
 
             if (unpark_reason_normal == reason)
-            {
-                if (1 != running_thread_count)
-                {
-                    unsigned const index = this->rand(running_thread_count, sched_type_sched);
-                    thread_index = this->running_threads[index];
-                }
-                else
-                {
-                    thread_index = this->running_threads[0];
-                }
-            }
+                thread_index = self().select_thread(&t);
         }
         else
         {
@@ -230,19 +324,126 @@ public:
             thread_index = t.index_;
         }
 
+        if (por_)
+            sleep_step(thread_index);
+
         if (t.index_ == thread_index)
             return thread_index;
 
         //t.subsequent_timed_waits_ = 0;
-        self().on_switch(t);
+        // scripted switches aren't part of the explored freedom
+        if ((thread_id_t)-1 == scripted)
+            self().on_switch(t);
 
         return thread_index;
     }
 
+    // Chooses which of running threads runs next, 'current' is the thread
+    // which reached the scheduling point (0 at iteration start).
+    thread_id_t select_thread(thread_info_t const* current)
+    {
+        thread_id_t candidates [thread_count];
+        thread_id_t count = 0;
+        uint64_t asleep = 0;
+        for (thread_id_t i = 0; i != this->running_threads_count; ++i)
+        {
+            thread_id_t const th = this->running_threads[i];
+            if (symmetric_duplicate(th))
+                continue;
+            if (por_ && (sleep_ >> th & 1))
+                asleep |= 1ull << count;
+            candidates[count++] = th;
+        }
+        // every execution from here is a reordering of an explored one
+        if (asleep && asleep == ~0ull >> (64 - count))
+            redundant_ = true;
+        if (current && 1 == count)
+            return candidates[0];
+        next_skip_ = asleep;
+        candidates_ = candidates;
+        unsigned const index = this->rand(count, sched_type_sched);
+        candidates_ = 0;
+        if (por_ && 0 == guide_)
+        {
+            // threads of the branches explored before this one sleep
+            // until something they depend on runs
+            stree_node const& n = stree_[stree_depth_ - 1];
+            for (unsigned i = 0; i != n.index_; ++i)
+                sleep_ |= 1ull << candidates[node_branch(n, i)];
+        }
+        return candidates[index];
+    }
+
+    // Thread which hasn't started yet, while a running lower-index thread
+    // of its symmetry group hasn't started either: starting this one
+    // first gives the same executions up to renaming of the threads.
+    bool symmetric_duplicate(thread_id_t th) const
+    {
+        thread_info_t const& t = this->threads_[th];
+        if (-1 == t.symmetry_group_ || t.started_)
+            return false;
+        for (thread_id_t i = 0; i != th; ++i)
+        {
+            thread_info_t const& s = this->threads_[i];
+            if (s.symmetry_group_ == t.symmetry_group_ && false == s.started_
+                && s.state_ == thread_state_running)
+                return true;
+        }
+        return false;
+    }
+
     void thread_finished_impl()
     {
     }
 
+    // Derived scheduler which explores all interleavings can set it,
+    // sleep sets are unsound with bounded search.
+    static bool const supports_sleep_sets = false;
+
+    // State caching (test_suite::state_hash()): the first visit of a state
+    // is remembered with its position in the tree. A later visit from another
+    // part of the tree at the same or greater depth can only repeat what is
+    // explored from the first one, so the rest of the execution is completed
+    // without branching. So is a visit on the path of the first one at
+    // a different depth, i.e. the state repeats within the execution;
+    // if no thread yielded in between, it's reported as livelock.
+    bool visit_state_impl(uint64_t hash, size_t depth, size_t yields)
+    {
+        if (redundant_ || guide_ || 1 != this->params_.shard_count)
+            return false;
+        hash = hash_mix(hash, sched_state_hash());
+        state_visit const v = {depth, yields, stree_depth_,
+            stree_depth_ ? stree_[stree_depth_ - 1].key_ : 0,
+            stree_depth_ ? stree_[stree_depth_ - 1].index_ : 0};
+        typename visited_t::iterator it = visited_.find(hash);
+        if (it == visited_.end())
+        {
+            visited_.insert(std::make_pair(hash, v));
+            return false;
+        }
+        state_visit& first = it->second;
+        if (on_current_path(first))
+        {
+            if (first.depth_ == depth)
+                return false;
+            if (first.yields_ == yields)
+                return true;
+            redundant_ = true;
+        }
+        else if (first.depth_ <= depth)
+            redundant_ = true;
+        else
+            first = v;
+        return false;
+    }
+
+    // Part of the derived scheduler state which affects the rest
+    // of the execution (e.g. remaining bound).
+    unsigned search_state() const
+    {
+        return 0;
+    }
+
     void purge_blocked_threads()
     {
         for (thread_id_t i = 0; i != thread_count; ++i)
@@ -251,14 +452,45 @@ public:
         }
     }
 
+    void allow_divergence_impl()
+    {
+        divergence_allowed_ = true;
+    }
+
     unsigned rand_impl(unsigned limit, sched_type t)
     {
+        bool const split = shard_split(limit);
+        uint64_t const skip = redundant_ ? ~0ull : next_skip_;
+        next_skip_ = 0;
         unsigned result = 0;
+        if (divergence_allowed_ && stree_depth_ != stree_.size())
+        {
+            // the rest of a state which doesn't fit the test is dropped,
+            // execution goes on as a new path
+            stree_node const& n = stree_[stree_depth_];
+            if (n.type_ != t || n.count_ != limit || n.index_ >= n.count_)
+                stree_.resize(stree_depth_);
+        }
         size_t const size = stree_.size();
         if (stree_depth_ == size)
         {
-            stree_node n = {limit, 0, t};
+            stree_node n = {limit, 0, t, node_key(stree_depth_), skip};
+            if (split)
+                n.index_ = first_shard_branch(limit);
+            if (guide_)
+                n.index_ = branch_index(n, guided_branch(limit, t));
             stree_.push_back(n);
+            if (0 == guide_ && skipped(n, node_branch(n)))
+            {
+                unsigned const next = next_branch(stree_depth_, n.index_, shard_path_owned());
+                if (next != limit)
+                    stree_.back().index_ = next;
+                else
+                    redundant_ = true;
+            }
+            result = node_branch(stree_.back());
+            if (this->params_.collect_tree_stats)
+                this->params_.tree_stats.add_node(stree_depth_, limit, t, ctx().sched_site());
         }
         else
         {
@@ -273,27 +505,61 @@ public:
 
             RL_VERIFY(n.count_ == limit);
             RL_VERIFY(n.index_ < n.count_);
-            result = n.index_;
+            n.skip_ = skip;
+            result = node_branch(n);
         }
+        if (trace_)
+            trace_branch(limit, t, result);
         stree_depth_ += 1;
         return result;
     }
 
-    iteration_t iteration_count_impl()
+    // Records decisions of following executions into 'trace',
+    // new decisions (past replayed initial state) follow 'guide' if it's set.
+    // Every thread consumes guide steps made by the same thread in order,
+    // so that changing one step doesn't shift decisions of other threads;
+    // chosen thread is switched to if it's runnable, otherwise current thread continues.
+    void set_guide(schedule_trace const* guide, schedule_trace* trace)
     {
-        double current = self().iteration_count_approx();
-        if (current <= this->iter_)
-            current = this->iter_ + 1.0;
+        guide_ = guide;
+        trace_ = trace;
+        for (thread_id_t i = 0; i != thread_count + 1; ++i)
+            guide_pos_[i] = 0;
+    }
 
-        iteration_count_mean_ *= iteration_count_probe_count_;
-        iteration_count_probe_count_ += 1;
-        iteration_count_mean_ /= iteration_count_probe_count_;
-        iteration_count_mean_ += current / iteration_count_probe_count_;
+    iteration_estimate iteration_estimate_impl()
+    {
+        // every unexplored branch on the current path holds at least one execution
+        bool const owned = shard_path_owned();
+        double lower = (double)this->iter_;
+        for (size_t i = 0; i != stree_.size(); ++i)
+        {
+            for (unsigned j = next_branch(i, stree_[i].index_, owned);
+                j != stree_[i].count_; j = next_branch(i, j, owned))
+                lower += 1;
+        }
 
-        iteration_t result = (iteration_t)(iteration_count_mean_ + 0.5);
-        if (result <= this->iter_)
-            result = this->iter_ + 1;
-        return result;
+        // a shard owns roughly 1/shard_count of the tree
+        double const shards = (double)this->params_.shard_count;
+        double const explored = (explored_initial_ + sample_weight_) * shards;
+        iteration_estimate e = {explored < 1 ? explored : 1, lower, lower, HUGE_VAL};
+        if (0 == sample_count_)
+            return e;
+
+        // weighted variance of path estimates, with effective sample size
+        // reduced according to how uneven the weights are
+        double const mean = sample_count_ / sample_weight_;
+        double const variance = (sample_value_ - 2 * mean * sample_count_
+            + mean * mean * sample_weight_) / sample_weight_;
+        double const effective_count = sample_weight_ * sample_weight_ / sample_weight_sq_;
+        double const error = 2 * sqrt((variance > 0 ? variance : 0) / effective_count);
+        double const shard_mean = mean / shards;
+        double const shard_error = error / shards;
+
+        e.mean = shard_mean > lower ? shard_mean : lower;
+        e.lower = shard_mean - shard_error > lower ? shard_mean - shard_error : lower;
+        e.upper = shard_mean + shard_error > e.mean ? shard_mean + shard_error : e.mean;
+        return e;
     }
 
     void get_state_impl(std::ostream& ss)
@@ -320,8 +586,17 @@ public:
             unsigned type = 0;
             ss >> type;
             n.type_ = static_cast<sched_type>(type);
+            n.key_ = node_key(i);
             stree_.push_back(n);
         }
+
+        // everything to the left of the initial path is already explored
+        double weight = 1;
+        for (size_t i = 0; i != stree_.size(); ++i)
+        {
+            explored_initial_ += weight * stree_[i].index_ / stree_[i].count_;
+            weight /= stree_[i].count_;
+        }
     }
 
     void on_thread_block(thread_id_t th, bool yield)
@@ -347,12 +622,16 @@ public:
     }
 
 protected:
+    // index_ is the position of the current branch in exploration order,
+    // see node_branch(); skip_ has bits of branches sleep sets exclude
+    // (bit 63 stands for all branches from 63 on).
     struct stree_node
     {
         unsigned    count_;
         unsigned    index_;
         sched_type  type_;
-        unsigned    pad_;
+        unsigned    key_;
+        uint64_t    skip_;
     };
 
     typedef rl_vector<stree_node> stree_t;
@@ -360,8 +639,313 @@ protected:
     size_t          stree_depth_;
 
 private:
-    double          iteration_count_mean_;
-    unsigned        iteration_count_probe_count_;
+    // Sharding: all shards explore the top of the tree, and every path
+    // is split at the first node where the number of paths through
+    // that level (product of count_ above) reaches shard_split_factor * shard_count.
+    // Branches of the split node are assigned to shards by hash of the path
+    // leading to them, so shards agree on ownership without talking to each other.
+    // A shard which owns no branch of a split node still completes one
+    // execution through it, but doesn't backtrack below it.
+    static unsigned const shard_split_factor = 16;
+    static size_t const no_split = (size_t)-1;
+    double          shard_mass_;
+    size_t          shard_split_depth_;
+
+    // Guided search (minimize_schedule, see set_guide()): new decisions
+    // follow guide_, guide_pos_ is the next step of every thread
+    // (the last one is for decisions made before any thread runs).
+    // Steps name threads, so branches of thread choices are mapped
+    // through candidates_, threads select_thread() chooses from (0 otherwise).
+    schedule_trace const* guide_;
+    schedule_trace* trace_;
+    size_t guide_pos_ [thread_count + 1];
+    thread_id_t const* candidates_;
+
+    bool divergence_allowed_;
+    rl_vector<script_step> const script_;
+    size_t script_pos_;
+
+    // Sleep sets (test_params::partial_order_reduction, Godefroid).
+    // Thread operations are independent if they access different atomic
+    // objects, anything else (mutexes, fences, thread start etc) depends
+    // on everything. After a branch of a thread switch is explored,
+    // its thread sleeps in the following branches until a thread
+    // it depends on runs: running it earlier gives a reordering
+    // of an execution which is already explored. pending_ is the object
+    // every thread is about to access, 0 - something else. An execution
+    // in which all runnable threads sleep is redundant, it's completed
+    // without branching.
+    bool const por_;
+    uint64_t sleep_;
+    uint64_t next_skip_;
+    bool redundant_;
+    void const* pending_ [thread_count];
+
+    struct state_visit
+    {
+        size_t      depth_;
+        size_t      yields_;
+        size_t      node_count_;    // tree nodes above the visit
+        unsigned    key_;           // key_ and index_ of the last of them
+        unsigned    index_;
+    };
+
+    typedef rl_map<uint64_t, state_visit> visited_t;
+    visited_t visited_;
+
+    bool on_current_path(state_visit const& v) const
+    {
+        if (0 == v.node_count_)
+            return true;
+        if (v.node_count_ > stree_.size())
+            return false;
+        stree_node const& n = stree_[v.node_count_ - 1];
+        return n.key_ == v.key_ && n.index_ == v.index_;
+    }
+
+    uint64_t sched_state_hash()
+    {
+        uint64_t h = hash_mix(self().search_state(), sleep_);
+        h = hash_mix(h, script_pos_);
+        for (thread_id_t i = 0; i != thread_count; ++i)
+        {
+            thread_info_t const& t = this->threads_[i];
+            h = hash_mix(h, t.state_);
+            h = hash_mix(h, t.block_count_);
+            h = hash_mix(h, t.started_);
+            for (thread_id_t j = 0; j != thread_count; ++j)
+            {
+                h = hash_mix(h, t.yield_priority_[j]);
+                h = hash_mix(h, t.yield_sched_count_[j]);
+            }
+        }
+        for (thread_id_t i = 0; i != this->timed_thread_count_; ++i)
+            h = hash_mix(h, this->timed_threads_[i]->index_);
+        for (thread_id_t i = 0; i != this->spurious_thread_count_; ++i)
+            h = hash_mix(h, thread_count + this->spurious_threads_[i]->index_);
+        return h;
+    }
+
+    void sleep_step(thread_id_t th)
+    {
+        void const* const object = pending_[th];
+        uint64_t sleep = 0;
+        for (thread_id_t i = 0; i != thread_count; ++i)
+        {
+            if ((sleep_ >> i & 1) && object && pending_[i] && pending_[i] != object)
+                sleep |= 1ull << i;
+        }
+        sleep_ = sleep & ~(1ull << th);
+    }
+
+    // Thread the schedule script makes run next, -1 if the script is over
+    // or its thread can't run now (then the choice is free).
+    // 'current' is the thread which reached a scheduling point, if any.
+    thread_id_t script_thread(thread_info_t const* current)
+    {
+        while (script_pos_ != script_.size())
+        {
+            script_step const& s = script_[script_pos_];
+            thread_info_t const& th = this->threads_[s.thread_];
+            bool const reached = s.site_.line_ && current == &th && s.site_.matches(ctx().sched_site());
+            if (false == reached && th.state_ != thread_state_finished)
+                return th.state_ == thread_state_running ? s.thread_ : (thread_id_t)-1;
+            script_pos_ += 1;
+            current = 0;
+        }
+        return (thread_id_t)-1;
+    }
+
+    thread_id_t current_thread() const
+    {
+        return this->thread_ ? this->thread_->index_ : (thread_id_t)-1;
+    }
+
+    schedule_step const* next_guide_step(sched_type t)
+    {
+        thread_id_t const th = current_thread();
+        size_t& pos = guide_pos_[th == (thread_id_t)-1 ? thread_count : th];
+        while (pos != guide_->size() && (*guide_)[pos].thread_ != th)
+            pos += 1;
+        if (pos == guide_->size())
+            return 0;
+        schedule_step const& step = (*guide_)[pos++];
+        return step.type_ == t ? &step : 0;
+    }
+
+    // Index of the current thread among candidates_, 'limit' if it's not one of them.
+    unsigned current_branch(unsigned limit) const
+    {
+        if (this->thread_)
+        {
+            for (unsigned i = 0; i != limit; ++i)
+            {
+                if (candidates_[i] == this->thread_->index_)
+                    return i;
+            }
+        }
+        return limit;
+    }
+
+    unsigned guided_branch(unsigned limit, sched_type t)
+    {
+        schedule_step const* step = next_guide_step(t);
+        unsigned const value = step ? step->value_ : schedule_step_continue;
+        if (sched_type_sched != t || 0 == candidates_)
+            return value < limit ? value : 0;
+        for (unsigned i = 0; i != limit; ++i)
+        {
+            if ((unsigned)candidates_[i] == value)
+                return i;
+        }
+        unsigned const current = current_branch(limit);
+        return current != limit ? current : 0;
+    }
+
+    void trace_branch(unsigned limit, sched_type t, unsigned index)
+    {
+        schedule_step step = {t, index, current_thread(), false};
+        if (sched_type_sched == t && candidates_)
+        {
+            unsigned const current = current_branch(limit);
+            step.value_ = candidates_[index];
+            step.preemption_ = current != limit && current != index;
+        }
+        trace_->push_back(step);
+    }
+
+    // With child_order_seed branches of a node are explored in order
+    // offset, offset + stride, offset + 2 * stride, ... (mod count_),
+    // where offset and stride (coprime to count_) are derived from a key
+    // which hashes the seed and the path to the node. So the search is still
+    // exhaustive, but doesn't spend its first hours under branch 0.
+    unsigned node_key(size_t depth) const
+    {
+        uint64_t h = depth
+            ? ((uint64_t)stree_[depth - 1].key_ << 32) + stree_[depth - 1].index_
+            : this->params_.child_order_seed;
+        h = (h + 1) * 0x9e3779b97f4a7c15ull;
+        h ^= h >> 31;
+        return (unsigned)(h * 0xbf58476d1ce4e5b9ull >> 32);
+    }
+
+    static unsigned gcd(unsigned a, unsigned b)
+    {
+        while (b)
+        {
+            unsigned const t = a % b;
+            a = b;
+            b = t;
+        }
+        return a;
+    }
+
+    unsigned node_branch(stree_node const& n) const
+    {
+        return node_branch(n, n.index_);
+    }
+
+    // Branch at position 'index' of exploration order of the node.
+    unsigned node_branch(stree_node const& n, unsigned index) const
+    {
+        if (0 == this->params_.child_order_seed || n.count_ < 2)
+            return index;
+        unsigned const offset = n.key_ % n.count_;
+        unsigned stride = (n.key_ >> 16) % n.count_ + 1;
+        while (1 != gcd(stride, n.count_))
+            stride = stride % n.count_ + 1;
+        return (unsigned)((offset + (uint64_t)index * stride) % n.count_);
+    }
+
+    // Position of 'branch' in exploration order of the node.
+    unsigned branch_index(stree_node const& n, unsigned branch) const
+    {
+        for (unsigned i = 0; i != n.count_; ++i)
+        {
+            if (node_branch(n, i) == branch)
+                return i;
+        }
+        return 0;
+    }
+
+    static bool skipped(stree_node const& n, unsigned branch)
+    {
+        return 0 != (n.skip_ >> (branch < 63 ? branch : 63) & 1);
+    }
+
+    bool shard_split(unsigned limit)
+    {
+        if (1 == this->params_.shard_count || no_split != shard_split_depth_)
+            return false;
+        shard_mass_ *= limit;
+        if (shard_mass_ < (double)shard_split_factor * this->params_.shard_count)
+            return false;
+        shard_split_depth_ = stree_depth_;
+        return true;
+    }
+
+    bool shard_owns(size_t depth, unsigned index) const
+    {
+        uint64_t h = 14695981039346656037ull;
+        for (size_t i = 0; i != depth; ++i)
+            h = (h ^ stree_[i].index_) * 1099511628211ull;
+        h = (h ^ index) * 1099511628211ull;
+        h ^= h >> 29;
+        return h % this->params_.shard_count == this->params_.shard_index;
+    }
+
+    unsigned first_shard_branch(unsigned limit) const
+    {
+        for (unsigned i = 0; i != limit; ++i)
+        {
+            if (shard_owns(stree_depth_, i))
+                return i;
+        }
+        return 0;
+    }
+
+    bool shard_path_owned() const
+    {
+        return no_split == shard_split_depth_
+            || shard_split_depth_ >= stree_.size()
+            || shard_owns(shard_split_depth_, stree_[shard_split_depth_].index_);
+    }
+
+    // Next branch of the node at 'depth' after 'index' this shard explores
+    // and sleep sets don't skip, count_ if there is none.
+    unsigned next_branch(size_t depth, unsigned index, bool path_owned) const
+    {
+        stree_node const& n = stree_[depth];
+        unsigned next = shard_next_branch(depth, index, path_owned);
+        while (next != n.count_ && skipped(n, node_branch(n, next)))
+            next = shard_next_branch(depth, next, path_owned);
+        return next;
+    }
+
+    unsigned shard_next_branch(size_t depth, unsigned index, bool path_owned) const
+    {
+        unsigned const count = stree_[depth].count_;
+        if (no_split == shard_split_depth_ || depth < shard_split_depth_)
+            return index + 1;
+        if (depth > shard_split_depth_)
+            return path_owned ? index + 1 : count;
+        for (unsigned i = index + 1; i != count; ++i)
+        {
+            if (shard_owns(depth, i))
+                return i;
+        }
+        return count;
+    }
+
+    // Knuth estimator: an execution reached with probability 'weight'
+    // (product of 1/count_ along its path) estimates tree size as 1/weight.
+    // Depth-first order is compensated by weighting every such estimate
+    // by its probability (weighted backtrack estimator).
+    double          explored_initial_;
+    double          sample_weight_;
+    double          sample_weight_sq_;
+    double          sample_value_;
+    iteration_t     sample_count_;
 
     derived_t& self()
     {
@@ -391,6 +975,8 @@ public:
     full_search_scheduler(const full_search_scheduler &) = delete;
     full_search_scheduler &operator=(const full_search_scheduler &) = delete;
 
+    static bool const supports_sleep_sets = true;
+
     bool can_switch(thread_info_t& /*t*/)
     {
         return true;
@@ -399,17 +985,6 @@ public:
     void on_switch(thread_info_t& /*t*/)
     {
     }
-
-    double iteration_count_approx()
-    {
-        double total = 1;
-        size_t const size = this->stree_.size();
-        for (size_t i = 0; i != size; ++i)
-        {
-            total *= this->stree_[i].count_;
-        }
-        return total;
-    }
 };
 
 
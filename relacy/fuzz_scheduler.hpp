@@ -0,0 +1,85 @@
+/*  Relacy Race Detector
+ *  Copyright (c) 2008-2013, Dmitry S. Vyukov
+ *  All rights reserved.
+ *  This software is provided AS-IS with no warranty, either express or implied.
+ *  This software is distributed under a license and may not be copied,
+ *  modified or distributed except as expressly authorized under the
+ *  terms of the license contained in the file LICENSE in this distribution.
+ */
+
+#pragma once
+
+#include "base.hpp"
+#include "random_scheduler.hpp"
+
+
+namespace rl
+{
+
+
+// Source of random_scheduler decisions taken from input bytes:
+// every decision with more than one alternative consumes as many bytes
+// as needed to represent limit - 1, exhausted input gives zeros.
+struct input_source
+{
+    input_source()
+        : data_()
+        , size_()
+        , pos_()
+    {
+    }
+
+    void set_input(uint8_t const* data, size_t size)
+    {
+        data_ = data;
+        size_ = size;
+        pos_ = 0;
+    }
+
+    void seed(iteration_t /*iter*/)
+    {
+        pos_ = 0;
+    }
+
+    unsigned next(unsigned limit)
+    {
+        unsigned value = 0;
+        for (unsigned rest = limit - 1; rest; rest >>= 8)
+        {
+            value <<= 8;
+            if (pos_ != size_)
+                value |= data_[pos_++];
+        }
+        return value % limit;
+    }
+
+private:
+    uint8_t const* data_;
+    size_t size_;
+    size_t pos_;
+};
+
+
+// Random scheduler which takes its decisions from input bytes instead of
+// a random generator, so that a fuzzing engine drives the execution
+// (see fuzz_one()).
+template<thread_id_t thread_count>
+class fuzz_scheduler : public random_scheduler<thread_count, input_source>
+{
+public:
+    typedef random_scheduler<thread_count, input_source> random_scheduler_t;
+    typedef typename random_scheduler_t::shared_context_t shared_context_t;
+
+    fuzz_scheduler(test_params& params, shared_context_t& ctx, thread_id_t dynamic_thread_count)
+        : random_scheduler_t(params, ctx, dynamic_thread_count)
+    {
+    }
+
+    void set_input(uint8_t const* data, size_t size)
+    {
+        this->source_.set_input(data, size);
+    }
+};
+
+
+}
@@ -0,0 +1,125 @@
+/*  Relacy Race Detector
+ *  Copyright (c) 2008-2013, Dmitry S. Vyukov
+ *  All rights reserved.
+ *  This software is provided AS-IS with no warranty, either express or implied.
+ *  This software is distributed under a license and may not be copied,
+ *  modified or distributed except as expressly authorized under the
+ *  terms of the license contained in the file LICENSE in this distribution.
+ */
+
+#pragma once
+
+#include "base.hpp"
+#include "full_search_scheduler.hpp"
+#include "random.hpp"
+
+
+namespace rl
+{
+
+
+// Random prefix, exhaustive suffix. The first hybrid_prefix_depth decisions
+// of an execution are random, seeded by the prefix number, so all executions
+// of one prefix share it; the rest of the execution is explored
+// with context bound search (context_bound preemptions). When the suffix tree
+// is exhausted the next prefix is drawn. The search stops after
+// iteration_count executions, like random search.
+template<thread_id_t thread_count>
+class hybrid_scheduler
+    : public tree_search_scheduler<hybrid_scheduler<thread_count>
+        , tree_search_scheduler_thread_info<thread_count>, thread_count>
+{
+public:
+    typedef tree_search_scheduler<hybrid_scheduler<thread_count>
+        , tree_search_scheduler_thread_info<thread_count>, thread_count> base_t;
+    typedef typename base_t::thread_info_t thread_info_t;
+    typedef typename base_t::shared_context_t shared_context_t;
+
+    hybrid_scheduler(test_params& params, shared_context_t& ctx, thread_id_t dynamic_thread_count)
+        : base_t(params, ctx, dynamic_thread_count)
+        , prefix_(1)
+    {
+    }
+
+    hybrid_scheduler(const hybrid_scheduler &) = delete;
+    hybrid_scheduler &operator=(const hybrid_scheduler &) = delete;
+
+    thread_id_t iteration_begin_impl()
+    {
+        rand_.seed(prefix_);
+        decisions_ = 0;
+        switches_remain_ = this->params_.context_bound;
+        return base_t::iteration_begin_impl();
+    }
+
+    bool iteration_end_impl()
+    {
+        bool const suffix_done = base_t::iteration_end_impl();
+        if (this->iter_ >= this->params_.iteration_count)
+            return true;
+        if (suffix_done)
+        {
+            prefix_ += 1;
+            this->stree_.clear();
+        }
+        return false;
+    }
+
+    unsigned rand_impl(unsigned limit, sched_type t)
+    {
+        if (decisions_++ < this->params_.hybrid_prefix_depth)
+            return rand_.rand() % limit;
+        return base_t::rand_impl(limit, t);
+    }
+
+    bool can_switch(thread_info_t& /*t*/)
+    {
+        prefix_switch_ = decisions_ < this->params_.hybrid_prefix_depth;
+        return prefix_switch_ || switches_remain_ != 0;
+    }
+
+    void on_switch(thread_info_t& t)
+    {
+        if (t.state_ == thread_state_running && false == prefix_switch_)
+        {
+            RL_VERIFY(switches_remain_);
+            switches_remain_ -= 1;
+        }
+    }
+
+    // executions of different prefixes don't explore the same subtrees,
+    // and a cycle in the random prefix doesn't have to repeat
+    bool visit_state_impl(uint64_t /*hash*/, size_t /*depth*/, size_t /*yields*/)
+    {
+        return false;
+    }
+
+    iteration_estimate iteration_estimate_impl()
+    {
+        double const total = (double)this->params_.iteration_count;
+        iteration_estimate const e = {this->iter_ / total, total, total, total};
+        return e;
+    }
+
+    void get_state_impl(std::ostream& ss)
+    {
+        ss << prefix_ << " ";
+        base_t::get_state_impl(ss);
+    }
+
+    void set_state_impl(std::istream& ss)
+    {
+        ss >> prefix_;
+        base_t::set_state_impl(ss);
+    }
+
+private:
+    random_generator rand_;
+    iteration_t prefix_;
+    unsigned decisions_;
+    unsigned switches_remain_;
+    bool prefix_switch_;
+};
+
+
+}
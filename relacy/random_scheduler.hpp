@@ -9,6 +9,8 @@
 
 #pragma once
 
+#include <stdexcept>
+
 #include "base.hpp"
 #include "scheduler.hpp"
 #include "random.hpp"
@@ -18,11 +20,58 @@ namespace rl
 {
 
 
-template<thread_id_t thread_count>
-class random_scheduler : public scheduler<random_scheduler<thread_count>, scheduler_thread_info, thread_count>
+// Pair of sites of test_params::target_sites: "push.hpp:42,pop.hpp:17".
+struct target_site_pair
+{
+    schedule_site               first_;
+    schedule_site               second_;
+};
+
+inline rl_vector<target_site_pair> parse_target_sites(string const& sites)
+{
+    rl_vector<target_site_pair> pairs;
+    istringstream ss (sites);
+    string token;
+    while (ss >> token)
+    {
+        size_t const comma = token.find(',');
+        target_site_pair pair;
+        if (comma == string::npos
+            || false == pair.first_.parse(token.substr(0, comma))
+            || false == pair.second_.parse(token.substr(comma + 1)))
+            throw std::logic_error("invalid target site pair: " + std::string(token.c_str()));
+        pairs.push_back(pair);
+    }
+    return pairs;
+}
+
+
+// Source of random_scheduler decisions: seed() is called at the beginning
+// of every iteration, next(limit) returns a value in [0, limit).
+// This one is a generator seeded by iteration number, see fuzz_scheduler
+// for a source which takes decisions from input bytes.
+struct random_source
+{
+    void seed(iteration_t iter)
+    {
+        rand_.seed(iter);
+    }
+
+    unsigned next(unsigned limit)
+    {
+        return rand_.rand() % limit;
+    }
+
+private:
+    random_generator rand_;
+};
+
+
+template<thread_id_t thread_count, typename source_t = random_source>
+class random_scheduler : public scheduler<random_scheduler<thread_count, source_t>, scheduler_thread_info, thread_count>
 {
 public:
-    typedef scheduler<random_scheduler<thread_count>, scheduler_thread_info, thread_count> base_t;
+    typedef scheduler<random_scheduler<thread_count, source_t>, scheduler_thread_info, thread_count> base_t;
     typedef typename base_t::thread_info_t thread_info_t;
     typedef typename base_t::shared_context_t shared_context_t;
 
@@ -32,7 +81,14 @@ public:
 
     random_scheduler(test_params& params, shared_context_t& ctx, thread_id_t dynamic_thread_count)
         : base_t(params, ctx, dynamic_thread_count)
+        , timed_factor_(4)
+        , spurious_factor_(8)
+        , cas_fail_factor_(4)
+        , run_length_()
+        , targets_(parse_target_sites(params.target_sites))
     {
+        for (thread_id_t i = 0; i != thread_count; ++i)
+            preemptible_[i] = true;
     }
 
     random_scheduler(const random_scheduler &) = delete;
@@ -40,25 +96,47 @@ public:
 
     thread_id_t iteration_begin_impl()
     {
-        rand_.seed(this->iter_);
+        source_.seed(this->iter_);
+        if (this->params_.swarm)
+            draw_swarm_config();
+        if (targets_.size())
+        {
+            for (thread_id_t i = 0; i != thread_count; ++i)
+                pending_[i] = debug_info();
+            held_ = -1;
+            follow_ = -1;
+            hold_count_ = 0;
+            directed_done_ = false;
+        }
         unpark_reason reason;
         return schedule_impl(reason, false);
     }
 
+    // Shards split iteration range into contiguous blocks,
+    // iterations are seeded by their number, so the blocks together
+    // give exactly the same executions as a single unsharded run.
+    iteration_t first_iteration_impl()
+    {
+        return shard_begin(this->params_.shard_index) + 1;
+    }
+
     bool iteration_end_impl()
     {
-        return this->iter_ == this->params_.iteration_count;
+        return this->iter_ >= shard_begin(this->params_.shard_index + 1);
     }
 
-    thread_id_t schedule_impl(unpark_reason& reason, unsigned /*yield*/)
+    thread_id_t schedule_impl(unpark_reason& reason, unsigned yield)
     {
+        RL_STAT(this->params_.stats.rand_calls[sched_type_sched]);
         thread_id_t const running_thread_count = this->running_threads_count;
+        if (targets_.size() && this->thread_)
+            pending_[this->thread_->index_] = ctx().sched_site();
 
         thread_id_t timed_thread_count = this->timed_thread_count_;
         if (timed_thread_count)
         {
-            thread_id_t cnt = running_thread_count ? timed_thread_count * 4 : timed_thread_count;
-            thread_id_t idx = rand_.rand() % cnt;
+            thread_id_t cnt = running_thread_count ? timed_thread_count * timed_factor_ : timed_thread_count;
+            thread_id_t idx = source_.next(cnt);
             if (idx < timed_thread_count)
             {
                 thread_info_t* thr = this->timed_threads_[idx];
@@ -74,8 +152,8 @@ public:
         thread_id_t spurious_thread_count = this->spurious_thread_count_;
         if (spurious_thread_count && running_thread_count)
         {
-            thread_id_t cnt = spurious_thread_count * 8;
-            thread_id_t idx = rand_.rand() % cnt;
+            thread_id_t cnt = spurious_thread_count * spurious_factor_;
+            thread_id_t idx = source_.next(cnt);
             if (idx < spurious_thread_count)
             {
                 thread_info_t* thr = this->spurious_threads_[idx];
@@ -89,16 +167,28 @@ public:
         }
 
         RL_VERIFY(running_thread_count);
-        unsigned index = rand_.rand() % running_thread_count;
-        thread_id_t th = this->running_threads[index];
         reason = unpark_reason_normal;
+        if (targets_.size())
+            return directed_thread();
+        if (this->params_.swarm && this->thread_)
+        {
+            thread_info_t& t = *this->thread_;
+            if (t.state_ == thread_state_running && false == preemptible_[t.index_]
+                && 0 == yield && ++run_length_ < swarm_quantum)
+                return t.index_;
+            run_length_ = 0;
+        }
+        unsigned index = source_.next(running_thread_count);
+        thread_id_t th = this->running_threads[index];
         return th;
     }
 
     unsigned rand_impl(unsigned limit, sched_type t)
     {
-        (void)t;
-        unsigned r = rand_.rand() % limit;
+        // spurious CAS failure is branch 0
+        if (sched_type_cas_fail == t && this->params_.swarm)
+            return source_.next(cas_fail_factor_) ? limit - 1 : 0;
+        unsigned r = source_.next(limit);
         ///!!!
 #ifdef RL_MY_TEST
         if (this->iter_ == 8761115)
@@ -111,9 +201,13 @@ public:
         return r;
     }
 
-    iteration_t iteration_count_impl()
+    iteration_estimate iteration_estimate_impl()
     {
-        return this->params_.iteration_count;
+        iteration_t const first = shard_begin(this->params_.shard_index);
+        double const total = (double)(shard_begin(this->params_.shard_index + 1) - first);
+        double const last = (double)(first + total);
+        iteration_estimate const e = {(this->iter_ - first) / total, last, last, last};
+        return e;
     }
 
     void get_state_impl(std::ostream& /*ss*/)
@@ -128,8 +222,113 @@ public:
     {
     }
 
+protected:
+    source_t source_;
+
 private:
-    random_generator rand_;
+    // Swarm testing (test_params::swarm): every iteration draws its own
+    // configuration, so that iterations differ in what they are likely to hit.
+    // Thread which is not preemptible keeps running until it blocks or yields,
+    // but at most swarm_quantum scheduling points in a row (spin loops
+    // without yield must still make progress). The factors are inverse
+    // probabilities of a timed wait timeout, of a spurious wakeup
+    // and of a spurious CAS failure.
+    static unsigned const swarm_quantum = 64;
+
+    bool preemptible_ [thread_count];
+    unsigned timed_factor_;
+    unsigned spurious_factor_;
+    unsigned cas_fail_factor_;
+    unsigned run_length_;
+
+    void draw_swarm_config()
+    {
+        unsigned const mask = source_.next(1 << 16);
+        for (thread_id_t i = 0; i != thread_count; ++i)
+            preemptible_[i] = 0 != (mask >> (i % 16) & 1);
+        timed_factor_ = 2 << source_.next(4);
+        spurious_factor_ = 2 << source_.next(5);
+        cas_fail_factor_ = 2 << source_.next(5);
+        run_length_ = 0;
+    }
+
+    // Directed search (test_params::target_sites): every iteration aims
+    // at one pair of sites, pair and order of the sites alternate with
+    // iteration number. A thread which is about to execute the first site
+    // is held until another thread is about to execute the second one,
+    // then they execute the sites back to back; the rest is random.
+    // A thread is held for at most directed_hold_limit scheduling points,
+    // so that threads waiting for it don't turn into livelock.
+    static unsigned const directed_hold_limit = 64;
+
+    rl_vector<target_site_pair> const targets_;
+    debug_info pending_ [thread_count];     // site each thread is about to execute
+    thread_id_t held_;
+    thread_id_t follow_;
+    unsigned hold_count_;
+    bool directed_done_;
+
+    bool is_running(thread_id_t th) const
+    {
+        return this->threads_[th].state_ == thread_state_running;
+    }
+
+    thread_id_t pending_at(schedule_site const& site, thread_id_t except) const
+    {
+        for (thread_id_t i = 0; i != this->running_threads_count; ++i)
+        {
+            thread_id_t const th = this->running_threads[i];
+            if (th != except && site.matches(pending_[th]))
+                return th;
+        }
+        return -1;
+    }
+
+    thread_id_t directed_thread()
+    {
+        if (-1 != follow_)
+        {
+            thread_id_t const th = follow_;
+            follow_ = -1;
+            if (is_running(th))
+                return th;
+        }
+
+        if (false == directed_done_)
+        {
+            iteration_t const n = this->iter_;
+            target_site_pair const& pair = targets_[(size_t)(n / 2 % targets_.size())];
+            schedule_site const& first = n % 2 ? pair.second_ : pair.first_;
+            schedule_site const& second = n % 2 ? pair.first_ : pair.second_;
+
+            if (-1 == held_ || false == is_running(held_))
+                held_ = pending_at(first, -1);
+            if (-1 != held_)
+            {
+                thread_id_t const th = held_;
+                follow_ = pending_at(second, th);
+                if (-1 != follow_ || 1 == this->running_threads_count || ++hold_count_ > directed_hold_limit)
+                {
+                    held_ = -1;
+                    directed_done_ = true;
+                    return th;
+                }
+                unsigned index = source_.next(this->running_threads_count - 1);
+                thread_id_t other = this->running_threads[index];
+                if (other == th)
+                    other = this->running_threads[this->running_threads_count - 1];
+                return other;
+            }
+        }
+
+        unsigned index = source_.next(this->running_threads_count);
+        return this->running_threads[index];
+    }
+
+    iteration_t shard_begin(unsigned shard) const
+    {
+        return this->params_.iteration_count * shard / this->params_.shard_count;
+    }
 };
 
 
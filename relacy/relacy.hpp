@@ -17,6 +17,7 @@
 #include "thread_local.hpp"
 #include "test_suite.hpp"
 #include "dyn_thread.hpp"
+#include "test_runner.hpp"
 
 #include "stdlib/mutex.hpp"
 #include "stdlib/condition_variable.hpp"
@@ -33,9 +33,58 @@ enum thread_finish_result
 
 
 
+// Estimate of total number of iterations required to explore the state space.
+struct iteration_estimate
+{
+    double                  explored;   // fraction of the state space already explored
+    double                  mean;
+    double                  lower;
+    double                  upper;      // +inf if unknown
+};
+
+
+
+inline bool parse_schedule_number(string const& s, unsigned long& value)
+{
+    char* end = 0;
+    value = strtoul(s.c_str(), &end, 10);
+    return s.size() && s[0] >= '0' && s[0] <= '9' && 0 == *end;
+}
+
+// Source location given by user as "file:line" or "line",
+// file is matched as a suffix of the source path.
+struct schedule_site
+{
+    string                  file_;
+    unsigned                line_;
+
+    bool parse(string const& s)
+    {
+        size_t const colon = s.rfind(':');
+        unsigned long line = 0;
+        if (false == parse_schedule_number(colon == string::npos ? s : s.substr(colon + 1), line) || 0 == line)
+            return false;
+        file_ = colon == string::npos ? string() : s.substr(0, colon);
+        line_ = (unsigned)line;
+        return true;
+    }
+
+    bool matches(debug_info const& info) const
+    {
+        if (info.line_ != line_)
+            return false;
+        size_t const len = strlen(info.file_);
+        return len >= file_.size()
+            && 0 == memcmp(info.file_ + len - file_.size(), file_.data(), file_.size());
+    }
+};
+
+
+
 struct scheduler_thread_info
 {
     thread_id_t             index_;
+    thread_id_t             symmetry_group_;    // -1 - not symmetric to any thread
     unsigned                block_count_;
     thread_state_e          state_;
 
@@ -69,15 +118,45 @@ public:
         , iter_()
         , thread_()
     {
+        RL_VERIFY(params.shard_count && params.shard_index < params.shard_count);
         for (thread_id_t i = 0; i != thread_count; ++i)
         {
             threads_[i].index_ = i;
+            threads_[i].symmetry_group_ = -1;
         }
     }
 
     scheduler(const scheduler &) = delete;
     scheduler &operator=(const scheduler &) = delete;
 
+    void set_symmetry_group(thread_id_t th, thread_id_t group)
+    {
+        RL_VERIFY(th < thread_count);
+        threads_[th].symmetry_group_ = group;
+    }
+
+    // Number of the first iteration of a fresh (not resumed) search.
+    iteration_t first_iteration()
+    {
+        return self().first_iteration_impl();
+    }
+
+    iteration_t first_iteration_impl()
+    {
+        return 1;
+    }
+
+    // Replayed state may be recorded by an older version of the test
+    // (corpus), then the scheduler doesn't insist that decisions match it.
+    void allow_divergence()
+    {
+        self().allow_divergence_impl();
+    }
+
+    void allow_divergence_impl()
+    {
+    }
+
     thread_id_t iteration_begin(iteration_t iter)
     {
         iter_ = iter;
@@ -129,12 +208,31 @@ public:
     unsigned rand(unsigned limit, sched_type t)
     {
         RL_VERIFY(limit);
+        RL_STAT(params_.stats.rand_calls[t]);
         return self().rand_impl(limit, t);
     }
 
     iteration_t iteration_count()
     {
-        return self().iteration_count_impl();
+        return (iteration_t)(self().iteration_estimate_impl().mean + 0.5);
+    }
+
+    iteration_estimate estimate_iteration_count()
+    {
+        return self().iteration_estimate_impl();
+    }
+
+    // Scheduling point reached state 'hash' after 'depth' scheduling points
+    // and 'yields' yields (see test_suite::state_hash()), returns true
+    // if the state repeats within the current execution without a yield.
+    bool visit_state(uint64_t hash, size_t depth, size_t yields)
+    {
+        return self().visit_state_impl(hash, depth, yields);
+    }
+
+    bool visit_state_impl(uint64_t /*hash*/, size_t /*depth*/, size_t /*yields*/)
+    {
+        return false;
     }
 
     bool park_current_thread(bool is_timed, bool allow_spurious_wakeup)
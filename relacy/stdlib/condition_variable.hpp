@@ -62,12 +62,14 @@ public:
 
     void notify_one(debug_info_param info)
     {
+        RL_STAT_SIM_SCOPE(ctx());
         check(info);
         impl_->notify_one(info);
     }
 
     void notify_all(debug_info_param info)
     {
+        RL_STAT_SIM_SCOPE(ctx());
         check(info);
         impl_->notify_all(info);
     }
@@ -75,6 +77,7 @@ public:
     template<typename lock_t>
     sema_wakeup_reason wait(lock_t& lock, bool is_timed, debug_info_param info)
     {
+        RL_STAT_SIM_SCOPE(ctx());
         check(info);
         mutex_wrapper_impl<lock_t> w (lock);
         return impl_->wait(w, is_timed, info);
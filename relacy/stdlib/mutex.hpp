@@ -71,6 +71,7 @@ public:
 
     bool lock_exclusive_timed(debug_info_param info)
     {
+        RL_STAT_SIM_SCOPE(ctx());
         return check(info)->lock_exclusive(true, info);
     }
 
@@ -81,36 +82,43 @@ public:
 
     void lock_exclusive(debug_info_param info)
     {
+        RL_STAT_SIM_SCOPE(ctx());
         check(info)->lock_exclusive(false, info);
     }
 
     bool try_lock_exclusive(debug_info_param info)
     {
+        RL_STAT_SIM_SCOPE(ctx());
         return check(info)->try_lock_exclusive(info);
     }
 
     void unlock_exclusive(debug_info_param info)
     {
+        RL_STAT_SIM_SCOPE(ctx());
         check(info)->unlock_exclusive(info);
     }
 
     void lock_shared(debug_info_param info)
     {
+        RL_STAT_SIM_SCOPE(ctx());
         check(info)->lock_shared(info);
     }
 
     bool try_lock_shared(debug_info_param info)
     {
+        RL_STAT_SIM_SCOPE(ctx());
         return check(info)->try_lock_shared(info);
     }
 
     void unlock_shared(debug_info_param info)
     {
+        RL_STAT_SIM_SCOPE(ctx());
         check(info)->unlock_shared(info);
     }
 
     void unlock_exclusive_or_shared(debug_info_param info)
     {
+        RL_STAT_SIM_SCOPE(ctx());
         check(info)->unlock_exclusive_or_shared(info);
     }
 
@@ -271,7 +271,7 @@ int rl_int_futex_impl(context& c,
     (void)val3;
     if (op == RL_FUTEX_WAIT)
     {
-        c.sched();
+        c.sched(info);
         c.atomic_thread_fence_seq_cst();
         int v0;
         {
@@ -295,7 +295,7 @@ int rl_int_futex_impl(context& c,
         if (val <= 0)
             return 0;
 
-        c.sched();
+        c.sched(info);
         c.atomic_thread_fence_seq_cst();
         return uaddr->wake(c, val, info);
     }
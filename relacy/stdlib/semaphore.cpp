@@ -42,7 +42,7 @@ sema_wakeup_reason wait_for_multiple_objects(
     debug_info_param info)
 {
     context& c = ctx();
-    c.sched();
+    c.sched(info);
 
     RL_VERIFY(count <= wfmo_max_objects);
     void* ws [wfmo_max_objects];
@@ -9,6 +9,10 @@
 
 #include "test_params.hpp"
 
+#include <iomanip>
+
+#include "history.hpp"
+
 namespace rl
 {
 
@@ -19,6 +23,8 @@ char const* format(scheduler_type_e t)
     case sched_random: return "random scheduler";
     case sched_bound: return "context bound scheduler";
     case sched_full: return "full search scheduler";
+    case sched_delay: return "delay bound scheduler";
+    case sched_hybrid: return "hybrid scheduler";
     default: break;
     }
     RL_VERIFY(false);
@@ -26,6 +32,185 @@ char const* format(scheduler_type_e t)
 }
 
 
+static char const* const sched_type_names [sched_type_count] =
+    {"sched", "atomic_load", "cas_fail", "mem_realloc", "user"};
+
+test_stats::test_stats()
+{
+    sched_calls             = 0;
+    fiber_switches          = 0;
+    for (int i = 0; i != sched_type_count; ++i)
+        rand_calls[i]       = 0;
+    load_index_steps        = 0;
+    allocs                  = 0;
+    frees                   = 0;
+    history_events          = 0;
+    invariant_calls         = 0;
+    user_time               = 0;
+    simulator_time          = 0;
+}
+
+static void output_stat(std::ostream& s, char const* name, uint64_t value, iteration_t iteration_count)
+{
+    s << name << ": " << value << " (" << (double)value / iteration_count << "/iteration)" << std::endl;
+}
+
+void test_stats::output(std::ostream& s, iteration_t iteration_count) const
+{
+    if (0 == iteration_count)
+        iteration_count = 1;
+
+    output_stat(s, "sched calls", sched_calls, iteration_count);
+    output_stat(s, "fiber switches", fiber_switches, iteration_count);
+    s << "rand calls:";
+    for (int i = 0; i != sched_type_count; ++i)
+        s << " " << sched_type_names[i] << "=" << rand_calls[i];
+    s << std::endl;
+    output_stat(s, "load index steps", load_index_steps, iteration_count);
+    output_stat(s, "allocs", allocs, iteration_count);
+    output_stat(s, "frees", frees, iteration_count);
+    output_stat(s, "history events", history_events, iteration_count);
+    output_stat(s, "invariant calls", invariant_calls, iteration_count);
+
+    uint64_t total_time = user_time + simulator_time;
+    if (0 == total_time)
+        total_time = 1;
+    s << "user time: " << user_time / 1000000 << "ms ("
+        << user_time * 100 / total_time << "%)" << std::endl;
+    s << "simulator time: " << simulator_time / 1000000 << "ms ("
+        << simulator_time * 100 / total_time << "%)" << std::endl;
+}
+
+
+search_tree_stats::search_tree_stats()
+{
+    for (int i = 0; i != sched_type_count; ++i)
+    {
+        branch_points[i] = 0;
+        branches[i] = 0;
+    }
+}
+
+void search_tree_stats::add_node(size_t depth, unsigned count, sched_type type, debug_info_param site)
+{
+    if (depths.size() <= depth)
+    {
+        depth_stats const zero = {};
+        depths.resize(depth + 1, zero);
+    }
+    depths[depth].nodes += 1;
+    depths[depth].branches += count;
+
+    if (count > 1)
+    {
+        branch_points[type] += 1;
+        branches[type] += count;
+        site_key const key = {site.file_, site.line_};
+        site_stats& ss = sites[key];
+        ss.func = site.func_;
+        ss.branch_points += 1;
+        ss.branches += count;
+    }
+}
+
+void search_tree_stats::add_path(size_t depth)
+{
+    if (depths.size() <= depth)
+    {
+        depth_stats const zero = {};
+        depths.resize(depth + 1, zero);
+    }
+    depths[depth].paths += 1;
+}
+
+static bool site_more_branching(std::pair<search_tree_stats::site_key, search_tree_stats::site_stats> const& l,
+                                std::pair<search_tree_stats::site_key, search_tree_stats::site_stats> const& r)
+{
+    return l.second.branch_points > r.second.branch_points;
+}
+
+void search_tree_stats::output(std::ostream& s, size_t top_site_count) const
+{
+    std::ios::fmtflags const flags = s.flags();
+    std::streamsize const precision = s.precision();
+
+    // deep trees are summarized in at most 16 depth ranges
+    size_t const range_count = 16;
+    size_t const range = (depths.size() + range_count - 1) / range_count;
+
+    s << "search tree:" << std::endl;
+    s << std::setw(12) << "depth" << std::setw(14) << "paths"
+        << std::setw(14) << "nodes" << std::setw(12) << "branching" << std::endl;
+    for (size_t begin = 0; begin < depths.size(); begin += range)
+    {
+        size_t const end = std::min(begin + range, depths.size());
+        depth_stats sum = {};
+        for (size_t d = begin; d != end; ++d)
+        {
+            sum.paths += depths[d].paths;
+            sum.nodes += depths[d].nodes;
+            sum.branches += depths[d].branches;
+        }
+        ostringstream depth;
+        depth << begin;
+        if (end - begin > 1)
+            depth << "-" << end - 1;
+        s << std::setw(12) << depth.str() << std::setw(14) << sum.paths
+            << std::setw(14) << sum.nodes << std::setw(12) << std::fixed << std::setprecision(2)
+            << (sum.nodes ? (double)sum.branches / sum.nodes : 0.0) << std::endl;
+    }
+
+    s << "branch points by type:" << std::endl;
+    for (int i = 0; i != sched_type_count; ++i)
+    {
+        s << "  " << sched_type_names[i] << ": " << branch_points[i];
+        if (branch_points[i])
+            s << " (avg branching " << (double)branches[i] / branch_points[i] << ")";
+        s << std::endl;
+    }
+
+    rl_vector<std::pair<site_key, site_stats> > top (sites.begin(), sites.end());
+    std::sort(top.begin(), top.end(), &site_more_branching);
+    if (top.size() > top_site_count)
+        top.resize(top_site_count);
+
+    s << "top branching sites:" << std::endl;
+    for (size_t i = 0; i != top.size(); ++i)
+    {
+        s << "  " << top[i].second.branch_points << " branch points, "
+            << top[i].second.branches << " branches: "
+            << debug_info(top[i].second.func, top[i].first.file, top[i].first.line) << std::endl;
+    }
+    s.flags(flags);
+    s.precision(precision);
+}
+
+
+static bool same_site(debug_info const& a, debug_info const& b)
+{
+    return a.file_ == b.file_ && a.line_ == b.line_;
+}
+
+bool test_failure::same(test_failure const& r) const
+{
+    if (result != r.result || false == same_site(site, r.site))
+        return false;
+    for (size_t i = 0; i != failure_signature_depth; ++i)
+    {
+        if (false == same_site(recent_sites[i], r.recent_sites[i]))
+            return false;
+    }
+    return true;
+}
+
+void test_failure::output(std::ostream& s) const
+{
+    s << description << std::endl;
+    s << "  at " << site << std::endl;
+    s << "  executions: " << count << ", first iteration: " << iteration << std::endl;
+    s << "  state: " << state << std::endl;
+}
+
 test_params::test_params()
 {
     iteration_count         = 1000;
@@ -36,10 +221,27 @@ test_params::test_params()
     output_history          = false;
     search_type             = random_scheduler_type;
     context_bound           = 1;
+    delay_bound             = 2;
+    hybrid_prefix_depth     = 50;
+    child_order_seed        = 0;
+    partial_order_reduction = false;
     execution_depth_limit   = 2000;
+    detect_spin_loops       = false;
+    collect_tree_stats      = false;
+    time_budget             = 0;
+    deadline                = 0;
+    shard_index             = 0;
+    shard_count             = 1;
+    minimize_schedule       = false;
+    collect_all_failures    = false;
+    swarm                   = false;
+    stop_flag               = 0;
 
     test_result             = test_result_success;
     stop_iteration          = 0;
+    time_limit_reached      = false;
+    search_stopped          = false;
+    explored_fraction       = 0;
 }
 
 }
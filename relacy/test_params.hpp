@@ -9,7 +9,9 @@
 
 #pragma once
 
+#include <atomic>
 #include <iostream>
+#include <time.h>
 
 #include "base.hpp"
 #include "test_result.hpp"
@@ -22,16 +24,98 @@ enum scheduler_type_e
     sched_random,
     sched_bound,
     sched_full,
+    sched_delay,
+    sched_hybrid,
     sched_count,
 
     random_scheduler_type = sched_random,
     fair_context_bound_scheduler_type = sched_bound,
     fair_full_search_scheduler_type = sched_full,
+    fair_delay_bound_scheduler_type = sched_delay,
+    hybrid_scheduler_type = sched_hybrid,
     scheduler_type_count
 };
 
 char const* format(scheduler_type_e t);
 
+// Hot-path counters, updated only when RL_COLLECT_STATS is defined.
+// Times are in nanoseconds.
+struct test_stats
+{
+    uint64_t                    sched_calls;
+    uint64_t                    fiber_switches;
+    uint64_t                    rand_calls [sched_type_count];
+    uint64_t                    load_index_steps;
+    uint64_t                    allocs;
+    uint64_t                    frees;
+    uint64_t                    history_events;
+    uint64_t                    invariant_calls;
+    uint64_t                    user_time;
+    uint64_t                    simulator_time;
+
+    test_stats();
+
+    void output(std::ostream& s, iteration_t iteration_count) const;
+};
+
+// Shape of the exploration tree of tree search schedulers
+// (full search, context bound), collected when requested by collect_tree_stats.
+struct search_tree_stats
+{
+    struct depth_stats
+    {
+        uint64_t                paths;      // executions of exactly this depth
+        uint64_t                nodes;      // tree nodes at this depth
+        uint64_t                branches;   // sum of branching factors of these nodes
+    };
+
+    struct site_key
+    {
+        char const*             file;
+        unsigned                line;
+
+        bool operator < (site_key const& r) const
+        {
+            return file != r.file ? file < r.file : line < r.line;
+        }
+    };
+
+    struct site_stats
+    {
+        char const*             func;
+        uint64_t                branch_points;
+        uint64_t                branches;
+    };
+
+    rl_vector<depth_stats>      depths;
+    uint64_t                    branch_points [sched_type_count];
+    uint64_t                    branches [sched_type_count];
+    rl_map<site_key, site_stats> sites;
+
+    search_tree_stats();
+
+    void add_node(size_t depth, unsigned count, sched_type type, debug_info_param site);
+    void add_path(size_t depth);
+    void output(std::ostream& s, size_t top_site_count = 10) const;
+};
+
+// Distinct failure found by a search with collect_all_failures.
+// Failures are the same if they have the same result, failing site
+// and last scheduling sites of the failing thread.
+struct test_failure
+{
+    test_result_e               result;
+    string                      description;
+    debug_info                  site;
+    debug_info                  recent_sites [failure_signature_depth];
+    iteration_t                 iteration;  // first execution which failed this way
+    uint64_t                    count;      // number of executions which failed this way
+    string                      state;      // initial_state which replays the first one
+
+    bool same(test_failure const& r) const;
+    void output(std::ostream& s) const;
+};
+
 struct test_params
 {
     // input params
@@ -43,14 +127,38 @@ struct test_params
     bool                        output_history;
     scheduler_type_e            search_type;
     unsigned                    context_bound;
+    unsigned                    delay_bound;
+    unsigned                    hybrid_prefix_depth;    // random decisions before exhaustive suffix
+    unsigned                    child_order_seed;       // tree search explores branches in seeded order, 0 - in index order
+    bool                        partial_order_reduction;    // full search skips reorderings of independent atomic accesses
     unsigned                    execution_depth_limit;
+    bool                        detect_spin_loops;  // repeated loads which see the same stores yield
     string                      initial_state;
+    bool                        collect_tree_stats;
+    unsigned                    time_budget;        // milliseconds, 0 - unlimited
+    time_t                      deadline;           // wall-clock time, 0 - none
+    unsigned                    shard_index;        // this process explores shard_index-th part
+    unsigned                    shard_count;        // of the search space split into shard_count parts
+    bool                        minimize_schedule;
+    bool                        collect_all_failures;
+    string                      corpus_dir;         // failing states are kept and replayed first, empty - none
+    string                      schedule_script;    // partial schedule for tree search schedulers
+    string                      target_sites;       // site pairs random scheduler directs search to
+    bool                        swarm;              // random scheduler draws its configuration every iteration
+    string                      portfolio;          // schedulers to run concurrently: "random bound:2 full"
+    std::atomic<bool>*          stop_flag;          // search stops when set, failure sets it
 
     // output params
     test_result_e               test_result;
     iteration_t                 stop_iteration;
     string                      test_name;
     string                      final_state;
+    bool                        time_limit_reached;
+    bool                        search_stopped;     // by stop_flag
+    double                      explored_fraction;
+    rl_vector<test_failure>     failures;
+    test_stats                  stats;
+    search_tree_stats           tree_stats;
 
     test_params();
 };
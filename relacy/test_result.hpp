@@ -53,6 +53,9 @@ enum test_result_e
 
     //dynamic thread
     test_result_thread_signal,
+
+    // forked worker died (see run_tests_forked())
+    test_result_worker_crash,
 };
 
 
@@ -95,6 +98,8 @@ inline char const* test_result_str(test_result_e r)
     case test_result_double_initialization_of_event: return "DOUBLE INITIALIZATION OF EVENT";
     case test_result_usage_of_non_initialized_event: return "USAGE OF NON INITIALIZED EVENT";
 
+    case test_result_worker_crash: return "WORKER CRASH";
+
     default: RL_VERIFY(false); return "UNKNOWN ERROR";
     }
 }
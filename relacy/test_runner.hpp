@@ -0,0 +1,93 @@
+/*  Relacy Race Detector
+ *  Copyright (c) 2008-2013, Dmitry S. Vyukov
+ *  All rights reserved.
+ *  This software is provided AS-IS with no warranty, either express or implied.
+ *  This software is distributed under a license and may not be copied,
+ *  modified or distributed except as expressly authorized under the
+ *  terms of the license contained in the file LICENSE in this distribution.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "base.hpp"
+#include "context.hpp"
+
+namespace rl
+{
+
+
+struct test_run_result
+{
+    bool                        passed;
+    test_params                 params;     // output params of the simulation
+    string                      output;     // everything the simulation printed
+    int                         crash_signal; // run_tests_forked() only, 0 if worker exited normally
+};
+
+
+// Runs a list of tests on a pool of OS threads.
+// Active context is per OS thread, so simulations don't interfere;
+// every test gets its own copy of 'params' with output and progress
+// redirected into test_run_result::output, results are stored in the
+// order of 'tests'. 'worker_count' == 0 means one worker per hardware thread.
+// Returns number of failed tests.
+inline size_t run_tests(simulate_f const* tests,
+                        size_t count,
+                        test_params const& params,
+                        test_run_result* results,
+                        unsigned worker_count = 0)
+{
+    if (0 == worker_count)
+        worker_count = std::thread::hardware_concurrency();
+    if (0 == worker_count)
+        worker_count = 1;
+    if (worker_count > count)
+        worker_count = (unsigned)count;
+
+    std::atomic<size_t> next (0);
+    std::atomic<size_t> failed (0);
+
+    auto worker = [&]()
+    {
+        for (;;)
+        {
+            size_t const i = next.fetch_add(1);
+            if (i >= count)
+                break;
+
+            ostringstream stream;
+            test_run_result& r = results[i];
+            r.crash_signal = 0;
+            r.params = params;
+            r.params.output_stream = &stream;
+            r.params.progress_stream = &stream;
+            r.passed = tests[i](r.params);
+            r.params.output_stream = 0;
+            r.params.progress_stream = 0;
+            r.output = stream.str();
+            if (false == r.passed)
+                failed.fetch_add(1);
+        }
+    };
+
+    if (worker_count <= 1)
+    {
+        worker();
+        return failed.load();
+    }
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i != worker_count; ++i)
+        threads.push_back(std::thread(worker));
+    for (size_t i = 0; i != threads.size(); ++i)
+        threads[i].join();
+    return failed.load();
+}
+
+
+}
@@ -0,0 +1,279 @@
+/*  Relacy Race Detector
+ *  Copyright (c) 2008-2013, Dmitry S. Vyukov
+ *  All rights reserved.
+ *  This software is provided AS-IS with no warranty, either express or implied.
+ *  This software is distributed under a license and may not be copied,
+ *  modified or distributed except as expressly authorized under the
+ *  terms of the license contained in the file LICENSE in this distribution.
+ */
+
+#pragma once
+
+// rl::run_tests_forked(), POSIX only, so it's not included by relacy.hpp.
+
+#include <stdexcept>
+#include <vector>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "test_runner.hpp"
+
+namespace rl
+{
+
+
+// Forked worker reports results through a pipe as a sequence of fields.
+inline void worker_write(int fd, void const* data, size_t size)
+{
+    char const* pos = static_cast<char const*>(data);
+    while (size)
+    {
+        ssize_t const n = ::write(fd, pos, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return;
+        pos += n;
+        size -= n;
+    }
+}
+
+inline void worker_write(int fd, uint64_t value)
+{
+    worker_write(fd, &value, sizeof(value));
+}
+
+inline void worker_write(int fd, string const& value)
+{
+    worker_write(fd, (uint64_t)value.size());
+    worker_write(fd, value.data(), value.size());
+}
+
+inline bool worker_read(string const& buf, size_t& pos, uint64_t& value)
+{
+    if (buf.size() - pos < sizeof(value))
+        return false;
+    memcpy(&value, buf.data() + pos, sizeof(value));
+    pos += sizeof(value);
+    return true;
+}
+
+inline bool worker_read(string const& buf, size_t& pos, string& value)
+{
+    uint64_t size = 0;
+    if (false == worker_read(buf, pos, size) || buf.size() - pos < size)
+        return false;
+    value.assign(buf.data() + pos, (size_t)size);
+    pos += (size_t)size;
+    return true;
+}
+
+// Report: passed, test_result, stop_iteration, crash signal, test name, final state, output.
+inline void worker_write_report(int fd, bool passed, test_params const& params, int sig, string const& output)
+{
+    worker_write(fd, (uint64_t)passed);
+    worker_write(fd, (uint64_t)params.test_result);
+    worker_write(fd, (uint64_t)params.stop_iteration);
+    worker_write(fd, (uint64_t)sig);
+    worker_write(fd, params.test_name);
+    worker_write(fd, params.final_state);
+    worker_write(fd, output);
+}
+
+inline bool worker_read_report(string const& buf, test_run_result& r)
+{
+    size_t pos = 0;
+    uint64_t passed = 0, res = 0, stop = 0, sig = 0;
+    if (false == worker_read(buf, pos, passed)
+        || false == worker_read(buf, pos, res)
+        || false == worker_read(buf, pos, stop)
+        || false == worker_read(buf, pos, sig)
+        || false == worker_read(buf, pos, r.params.test_name)
+        || false == worker_read(buf, pos, r.params.final_state)
+        || false == worker_read(buf, pos, r.output))
+        return false;
+    r.passed = 0 != passed;
+    r.params.test_result = (test_result_e)res;
+    r.params.stop_iteration = (iteration_t)stop;
+    r.crash_signal = (int)sig;
+    return true;
+}
+
+struct worker_crash_info
+{
+    int                         fd_;
+    ostringstream*              output_;
+};
+
+inline worker_crash_info& worker_crash()
+{
+    static worker_crash_info info;
+    return info;
+}
+
+// Runs on alternate stack, so stack overflow in a fiber is reported too.
+// The process is going down anyway, so the report is formatted
+// the usual way, alarm() kills the worker if that hangs on a broken heap.
+inline void worker_crash_handler(int sig)
+{
+    alarm(10);
+    worker_crash_info& info = worker_crash();
+    test_params params;
+    string output = info.output_->str();
+    if (has_ctx())
+    {
+        context& c = ctx();
+        ostringstream state;
+        c.get_replay_state(state);
+        params.test_name = c.params().test_name;
+        params.final_state = state.str();
+        istringstream iter (params.final_state);
+        iter >> params.stop_iteration;
+    }
+    params.test_result = test_result_worker_crash;
+    worker_write_report(info.fd_, false, params, sig, output);
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+inline void worker_main(simulate_f test, test_params const& params, int fd)
+{
+    static char alt_stack [64 * 1024];
+    stack_t ss = {};
+    ss.ss_sp = alt_stack;
+    ss.ss_size = sizeof(alt_stack);
+    sigaltstack(&ss, 0);
+
+    ostringstream stream;
+    worker_crash().fd_ = fd;
+    worker_crash().output_ = &stream;
+
+    struct sigaction sa = {};
+    sa.sa_handler = &worker_crash_handler;
+    sa.sa_flags = SA_ONSTACK;
+    sigemptyset(&sa.sa_mask);
+    int const signals [] = {SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT};
+    for (size_t i = 0; i != sizeof(signals) / sizeof(*signals); ++i)
+        sigaction(signals[i], &sa, 0);
+
+    test_params p = params;
+    p.output_stream = &stream;
+    p.progress_stream = &stream;
+    bool const passed = test(p);
+    worker_write_report(fd, passed, p, 0, stream.str());
+}
+
+
+// Same as run_tests(), but every test runs in a forked worker process,
+// at most 'worker_count' of them at a time. A worker which dies
+// (segfault in user code, abort, stack overflow in a fiber etc)
+// is reported as failed with test_result_worker_crash, crash_signal,
+// the iteration it died on in params.stop_iteration and params.final_state
+// which replays the execution up to the crash when passed as initial_state.
+// Only output params listed in the report are transferred back.
+// Returns number of failed tests.
+inline size_t run_tests_forked(simulate_f const* tests,
+                               size_t count,
+                               test_params const& params,
+                               test_run_result* results,
+                               unsigned worker_count = 0)
+{
+    if (0 == worker_count)
+        worker_count = std::thread::hardware_concurrency();
+    if (0 == worker_count)
+        worker_count = 1;
+
+    struct worker
+    {
+        pid_t                   pid_;
+        int                     fd_;
+        size_t                  test_;
+        string                  report_;
+    };
+
+    std::cout.flush();
+    std::cerr.flush();
+
+    std::vector<worker> workers;
+    size_t next = 0;
+    size_t failed = 0;
+    while (next != count || workers.size())
+    {
+        while (next != count && workers.size() < worker_count)
+        {
+            test_run_result& r = results[next];
+            r.passed = false;
+            r.params = params;
+            r.params.output_stream = 0;
+            r.params.progress_stream = 0;
+            r.crash_signal = 0;
+
+            int fds [2];
+            if (pipe(fds))
+                throw std::runtime_error("relacy: pipe() failed");
+            pid_t const pid = fork();
+            if (pid < 0)
+                throw std::runtime_error("relacy: fork() failed");
+            if (0 == pid)
+            {
+                ::close(fds[0]);
+                worker_main(tests[next], params, fds[1]);
+                ::close(fds[1]);
+                _exit(0);
+            }
+            ::close(fds[1]);
+            worker w = {pid, fds[0], next, string()};
+            workers.push_back(w);
+            next += 1;
+        }
+
+        std::vector<pollfd> pfds (workers.size());
+        for (size_t i = 0; i != workers.size(); ++i)
+        {
+            pfds[i].fd = workers[i].fd_;
+            pfds[i].events = POLLIN;
+            pfds[i].revents = 0;
+        }
+        if (poll(&pfds[0], pfds.size(), -1) < 0 && errno != EINTR)
+            throw std::runtime_error("relacy: poll() failed");
+
+        for (size_t i = workers.size(); i != 0; --i)
+        {
+            worker& w = workers[i - 1];
+            if (0 == pfds[i - 1].revents)
+                continue;
+            char buf [4096];
+            ssize_t const n = ::read(w.fd_, buf, sizeof(buf));
+            if (n > 0)
+            {
+                w.report_.append(buf, n);
+                continue;
+            }
+            if (n < 0 && errno == EINTR)
+                continue;
+
+            ::close(w.fd_);
+            int status = 0;
+            while (waitpid(w.pid_, &status, 0) < 0 && errno == EINTR) {}
+
+            test_run_result& r = results[w.test_];
+            if (false == worker_read_report(w.report_, r))
+            {
+                // died without a report (killed, exit() from the test etc)
+                r.passed = false;
+                r.params.test_result = test_result_worker_crash;
+                r.crash_signal = WIFSIGNALED(status) ? WTERMSIG(status) : 0;
+            }
+            if (false == r.passed)
+                failed += 1;
+            workers.erase(workers.begin() + (i - 1));
+        }
+    }
+    return failed;
+}
+
+
+}
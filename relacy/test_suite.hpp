@@ -35,6 +35,19 @@ struct test_suite
         static test_result_e const expected_result = result;
     };
 
+    // Threads of the same symmetry group (other than -1) run the same code
+    // and don't depend on their index, so tree search schedulers
+    // explore only one order in which they start.
+    static thread_id_t symmetry_group(thread_id_t /*index*/) { return -1; }
+
+    // Hash of everything in the test which determines how an execution
+    // goes on from a scheduling point: values of variables (atomics can be
+    // loaded the same way as in invariant()) and of whatever the threads
+    // keep in locals (loop counters etc), which must be mirrored in members.
+    // Non-zero value makes tree search schedulers cut executions
+    // which reach an already explored state.
+    size_t state_hash() { return 0; }
+
     void invariant() {}
     void before() {}
     void after() {}
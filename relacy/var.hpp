@@ -264,6 +264,7 @@ private:
     T load(debug_info_param info) const
     {
         context& c = ctx();
+        RL_STAT_SIM_SCOPE(c);
         sign_.check(info);
 
         if (false == initialized_)
@@ -295,6 +296,7 @@ private:
     void store(T v, debug_info_param info)
     {
         context& c = ctx();
+        RL_STAT_SIM_SCOPE(c);
         RL_VERIFY(false == c.invariant_executing);
         sign_.check(info);
 
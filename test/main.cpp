@@ -16,6 +16,8 @@
 #include "windows.hpp"
 #include "addr_hash.hpp"
 #include "futex.hpp"
+#include "runner.hpp"
+#include "search.hpp"
 
 #include "../relacy/stdlib/windows.hpp"
 #include "../relacy/stdlib/pthread.hpp"
@@ -500,39 +502,48 @@ int main()
 #endif
     };
 
+    size_t const test_count = sizeof(tests)/sizeof(*tests);
+
     for (size_t sched = 0; sched != rl::sched_count; ++sched)
     {
         std::cout << format((rl::scheduler_type_e)sched) << " tests:" << std::endl;
 
-        for (size_t i = 0; i != sizeof(tests)/sizeof(*tests); ++i)
+        std::vector<rl::simulate_f> sched_tests;
+        for (size_t i = 0; i != test_count; ++i)
         {
             //!!! make it work under sched_full
             if (sched == rl::sched_full
                 && (tests[i] == (rl::simulate_f)&rl::simulate<test_pthread_condvar>
                     || tests[i] == (rl::simulate_f)&rl::simulate<test_win_condvar>))
                 continue;
+            sched_tests.push_back(tests[i]);
+        }
+
+        rl::test_params params;
+        params.search_type = (rl::scheduler_type_e)sched;
+        params.iteration_count =
+            (params.test_result == rl::test_result_success ? 100000 : 500);
+        params.context_bound = 2;
+        params.delay_bound = 2;
+        params.execution_depth_limit = 500;
 
-            rl::ostringstream stream;
-            rl::test_params params;
-            params.search_type = (rl::scheduler_type_e)sched;
-            params.iteration_count =
-                (params.test_result == rl::test_result_success ? 100000 : 500);
-            params.output_stream = &stream;
-            params.progress_stream = &stream;
-            params.context_bound = 2;
-            params.execution_depth_limit = 500;
-
-            if (false == tests[i](params))
+        // tests are independent simulations, so run them concurrently
+        std::vector<rl::test_run_result> results (sched_tests.size());
+        rl::run_tests(&sched_tests[0], sched_tests.size(), params, &results[0]);
+
+        for (size_t i = 0; i != results.size(); ++i)
+        {
+            if (false == results[i].passed)
             {
                 std::cout << std::endl;
                 std::cout << "FAILED" << std::endl;
-                std::cout << stream.str();
+                std::cout << results[i].output;
                 std::cout << std::endl;
                 return 1;
             }
             else
             {
-                std::cout << params.test_name << "...OK" << std::endl;
+                std::cout << results[i].params.test_name << "...OK" << std::endl;
             }
         }
         std::cout << std::endl;
@@ -569,6 +580,44 @@ int main()
     }
     std::cout << std::endl;
 
+    // checks of what simulations report, rather than of the test result
+    struct feature_test
+    {
+        char const*     name;
+        bool            (*func)();
+    };
+
+    feature_test const feature_tests[] =
+    {
+        {"forked_runner_test", &forked_runner_test},
+        {"shard_cover_test", &shard_cover_test},
+        {"minimize_same_failure_test", &minimize_same_failure_test},
+        {"collect_all_failures_test", &collect_all_failures_test},
+        {"corpus_replay_test", &corpus_replay_test},
+        {"schedule_script_test", &schedule_script_test},
+        {"target_sites_test", &target_sites_test},
+        {"child_order_seed_test", &child_order_seed_test},
+        {"swarm_test", &swarm_test},
+        {"symmetric_minimize_test", &symmetric_minimize_test},
+        {"restore_pruning_test", &restore_pruning_test},
+        {"por_outcomes_test", &por_outcomes_test},
+        {"state_hash_cut_test", &state_hash_cut_test},
+        {"spin_loop_detect_test", &spin_loop_detect_test},
+    };
+
+    std::cout << "feature tests:" << std::endl;
+    for (size_t i = 0; i != sizeof(feature_tests)/sizeof(*feature_tests); ++i)
+    {
+        if (false == feature_tests[i].func())
+        {
+            std::cout << std::endl;
+            std::cout << feature_tests[i].name << "...FAILED" << std::endl;
+            return 1;
+        }
+        std::cout << feature_tests[i].name << "...OK" << std::endl;
+    }
+    std::cout << std::endl;
+
     std::cout << "SUCCESS" << std::endl;
 }
 
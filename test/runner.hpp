@@ -0,0 +1,87 @@
+#pragma once
+
+#include "../relacy/relacy.hpp"
+
+#ifndef _WIN32
+#include "../relacy/test_runner_forked.hpp"
+#include <stdlib.h>
+#endif
+
+
+
+struct worker_crash_test : rl::test_suite<worker_crash_test, 2>
+{
+    rl::atomic<int> x;
+
+    void before()
+    {
+        x($) = 0;
+    }
+
+    void thread(unsigned index)
+    {
+        if (index)
+        {
+            x($).store(1, rl::memory_order_relaxed);
+        }
+        else
+        {
+            // crashes the process only in some interleavings
+            if (1 == x($).load(rl::memory_order_relaxed))
+                abort();
+        }
+    }
+};
+
+
+
+
+struct worker_ok_test : rl::test_suite<worker_ok_test, 2>
+{
+    rl::atomic<int> x;
+
+    void before()
+    {
+        x($) = 0;
+    }
+
+    void thread(unsigned /*index*/)
+    {
+        x($).fetch_add(1, rl::memory_order_relaxed);
+    }
+
+    void after()
+    {
+        RL_ASSERT(2 == x($).load(rl::memory_order_relaxed));
+    }
+};
+
+
+
+
+// Crashed worker is reported with the state of the execution,
+// the tests after it still run.
+inline bool forked_runner_test()
+{
+#ifndef _WIN32
+    rl::simulate_f tests [] =
+    {
+        &rl::simulate<worker_crash_test>,
+        &rl::simulate<worker_ok_test>,
+    };
+    rl::test_params params;
+    params.search_type = rl::sched_full;
+    rl::test_run_result results [2];
+    size_t const failed = rl::run_tests_forked(tests, 2, params, results, 1);
+
+    return 1 == failed
+        && false == results[0].passed
+        && rl::test_result_worker_crash == results[0].params.test_result
+        && SIGABRT == results[0].crash_signal
+        && results[0].params.final_state.size()
+        && results[0].params.stop_iteration
+        && results[1].passed;
+#else
+    return true;
+#endif
+}
@@ -0,0 +1,923 @@
+#pragma once
+
+#include "../relacy/relacy.hpp"
+#include <cstdio>
+
+
+
+template<typename test_t>
+bool simulate_quiet(rl::test_params& params)
+{
+    rl::ostringstream stream;
+    params.output_stream = &stream;
+    params.progress_stream = &stream;
+    return rl::simulate<test_t>(params);
+}
+
+
+
+
+// executions seen by the current simulation, keyed as the test likes
+inline rl::rl_map<rl::string, int>*& seen_executions()
+{
+    static rl::rl_map<rl::string, int>* executions = 0;
+    return executions;
+}
+
+struct shard_test : rl::test_suite<shard_test, 3>
+{
+    rl::atomic<int> a;
+
+    void before()
+    {
+        a($) = 0;
+    }
+
+    void thread(unsigned /*index*/)
+    {
+        a($).fetch_add(1, rl::memory_order_relaxed);
+        a($).fetch_add(1, rl::memory_order_relaxed);
+    }
+
+    void after()
+    {
+        rl::ostringstream stream;
+        rl::ctx().get_replay_state(stream);
+        rl::string const state = stream.str();
+        // replay state without iteration number
+        (*seen_executions())[state.substr(state.find(' '))] += 1;
+    }
+};
+
+// Shards together explore every execution of the unsharded search.
+inline bool shard_cover_test()
+{
+    rl::scheduler_type_e const types [] = {rl::sched_full, rl::sched_bound};
+    for (size_t t = 0; t != sizeof(types) / sizeof(*types); ++t)
+    {
+        rl::rl_map<rl::string, int> all;
+        seen_executions() = &all;
+        rl::test_params params;
+        params.search_type = types[t];
+        params.context_bound = 2;
+        if (false == simulate_quiet<shard_test>(params))
+            return false;
+
+        rl::rl_map<rl::string, int> sharded;
+        seen_executions() = &sharded;
+        rl::iteration_t iterations = 0;
+        for (unsigned i = 0; i != 3; ++i)
+        {
+            rl::test_params p;
+            p.search_type = types[t];
+            p.context_bound = 2;
+            p.shard_index = i;
+            p.shard_count = 3;
+            if (false == simulate_quiet<shard_test>(p))
+                return false;
+            iterations += p.stop_iteration;
+        }
+        seen_executions() = 0;
+
+        if (all.size() != params.stop_iteration
+            || iterations < params.stop_iteration
+            || sharded.size() != all.size())
+            return false;
+        for (rl::rl_map<rl::string, int>::const_iterator i = all.begin(); i != all.end(); ++i)
+        {
+            if (0 == sharded.count(i->first))
+                return false;
+        }
+    }
+    return true;
+}
+
+
+
+
+inline bool& minimize_check_second()
+{
+    static bool check = false;
+    return check;
+}
+
+struct minimize_test : rl::test_suite<minimize_test, 2>
+{
+    rl::atomic<int> x;
+
+    void before()
+    {
+        x($) = 0;
+    }
+
+    void thread(unsigned index)
+    {
+        if (0 == index)
+        {
+            x($).store(1);
+            x($).store(2);
+        }
+        else
+        {
+            int const v = x($).load();
+            // needs a preemption between the stores
+            RL_ASSERT(v != 1);
+            // fails without preemptions
+            RL_ASSERT(false == minimize_check_second() || v != 2);
+        }
+    }
+};
+
+// Minimization doesn't swap the failure for a different one
+// which needs fewer preemptions.
+inline bool minimize_same_failure_test()
+{
+    rl::test_params params;
+    params.search_type = rl::sched_full;
+    minimize_check_second() = false;
+    if (simulate_quiet<minimize_test>(params))
+        return false;
+
+    rl::test_params p;
+    p.search_type = rl::sched_full;
+    p.initial_state = params.final_state;
+    p.minimize_schedule = true;
+    minimize_check_second() = true;
+    bool const passed = simulate_quiet<minimize_test>(p);
+    minimize_check_second() = false;
+    return false == passed && p.final_state == params.final_state;
+}
+
+
+
+
+struct collect_failures_test : rl::test_suite<collect_failures_test, 2>
+{
+    rl::atomic<int> x;
+
+    void before()
+    {
+        x($) = 0;
+    }
+
+    void thread(unsigned index)
+    {
+        if (0 == index)
+        {
+            x($).store(1);
+            x($).store(2);
+        }
+        else
+        {
+            int const v = x($).load();
+            RL_ASSERT(v != 1);
+            RL_ASSERT(v != 2);
+        }
+    }
+};
+
+// Both bugs are reported, each once, with a state which replays it.
+inline bool collect_all_failures_test()
+{
+    rl::test_params params;
+    params.search_type = rl::sched_full;
+    params.collect_all_failures = true;
+    if (simulate_quiet<collect_failures_test>(params))
+        return false;
+    if (2 != params.failures.size()
+        || params.failures[0].site.line_ == params.failures[1].site.line_)
+        return false;
+    for (size_t i = 0; i != params.failures.size(); ++i)
+    {
+        rl::test_params p;
+        p.search_type = rl::sched_full;
+        p.initial_state = params.failures[i].state;
+        if (simulate_quiet<collect_failures_test>(p)
+            || p.test_result != params.failures[i].result
+            || p.stop_iteration != params.failures[i].iteration)
+            return false;
+    }
+    return true;
+}
+
+
+
+
+inline bool& corpus_bug_fixed()
+{
+    static bool fixed = false;
+    return fixed;
+}
+
+struct corpus_test : rl::test_suite<corpus_test, 3>
+{
+    rl::atomic<int> x;
+
+    void before()
+    {
+        x($) = 0;
+    }
+
+    void thread(unsigned index)
+    {
+        if (2 != index)
+        {
+            x($).fetch_add(1);
+        }
+        else
+        {
+            // sees every value in turn in few interleavings
+            int const v0 = x($).load();
+            int const v1 = x($).load();
+            int const v2 = x($).load();
+            RL_ASSERT(corpus_bug_fixed() || v0 != 0 || v1 != 1 || v2 != 2);
+        }
+    }
+};
+
+template<typename test_t>
+bool simulate_corpus(rl::test_params& params, rl::string& output)
+{
+    rl::ostringstream stream;
+    params.output_stream = &stream;
+    params.progress_stream = &stream;
+    params.search_type = rl::sched_random;
+    params.corpus_dir = ".";
+    bool const passed = rl::simulate<test_t>(params);
+    output = stream.str();
+    return passed;
+}
+
+// Failure found by a search is replayed by the next run
+// before the search, and passes once the bug is fixed.
+inline bool corpus_replay_test()
+{
+    rl::string output;
+    corpus_bug_fixed() = false;
+    // the first run learns the corpus path, and drops states left by earlier runs
+    rl::test_params first;
+    if (simulate_corpus<corpus_test>(first, output))
+        return false;
+    std::remove(rl::corpus_path(first).c_str());
+    rl::test_params params;
+    if (simulate_corpus<corpus_test>(params, output)
+        || rl::string::npos != output.find("corpus:"))
+        return false;
+
+    // search alone doesn't find it in one iteration
+    rl::test_params p;
+    p.iteration_count = 1;
+    bool const reproduced = false == simulate_corpus<corpus_test>(p, output)
+        && rl::string::npos != output.find("corpus: failure reproduced by state 1 of 1")
+        && p.final_state == params.final_state;
+
+    corpus_bug_fixed() = true;
+    rl::test_params f;
+    f.iteration_count = 1;
+    bool const passed = simulate_corpus<corpus_test>(f, output)
+        && rl::string::npos != output.find("corpus: 1 states passed");
+    corpus_bug_fixed() = false;
+
+    std::remove(rl::corpus_path(params).c_str());
+    return reproduced && passed;
+}
+
+
+
+
+struct script_test : rl::test_suite<script_test, 3>
+{
+    // line of the second store of thread 0 below
+    static unsigned const second_store_line = __LINE__ + 14;
+
+    rl::atomic<int> x;
+
+    void before()
+    {
+        x($) = 0;
+    }
+
+    void thread(unsigned index)
+    {
+        if (0 == index)
+        {
+            x($).store(1);
+            x($).store(2);
+        }
+        else if (1 == index)
+        {
+            int const v = x($).load();
+            RL_ASSERT(v != 1);
+        }
+        else
+        {
+            x($).load();
+            x($).load();
+        }
+    }
+};
+
+// Script pins the failing interleaving, so the failure is the first
+// execution of any tree search, and the same one every run.
+inline bool schedule_script_test()
+{
+    rl::ostringstream script;
+    script << "0@search.hpp:" << script_test::second_store_line << " 1";
+
+    rl::test_params params;
+    params.search_type = rl::sched_full;
+    if (simulate_quiet<script_test>(params) || 1 == params.stop_iteration)
+        return false;
+
+    rl::scheduler_type_e const types [] = {rl::sched_full, rl::sched_bound, rl::sched_delay};
+    for (size_t t = 0; t != sizeof(types) / sizeof(*types); ++t)
+    {
+        rl::string state;
+        for (int run = 0; run != 2; ++run)
+        {
+            rl::test_params p;
+            p.search_type = types[t];
+            p.schedule_script = script.str();
+            if (simulate_quiet<script_test>(p)
+                || 1 != p.stop_iteration
+                || (run && p.final_state != state))
+                return false;
+            state = p.final_state;
+        }
+    }
+    return true;
+}
+
+
+
+
+struct race_window_test : rl::test_suite<race_window_test, 4>
+{
+    // lines of the load and of the store which closes the window below
+    static unsigned const check_line = __LINE__ + 16;
+    static unsigned const clear_line = __LINE__ + 21;
+
+    rl::atomic<int> flag;
+    rl::atomic<int> noise;
+
+    void before()
+    {
+        flag($) = 0;
+        noise($) = 0;
+    }
+
+    void thread(unsigned index)
+    {
+        // the load is usually done long before the stores
+        if (1 == index)
+            RL_ASSERT(0 == flag($).load());
+        for (int i = 0; i != 8; ++i)
+            noise($).fetch_add(1);
+        if (0 == index)
+        {
+            flag($).store(1);
+            flag($).store(0);
+        }
+    }
+};
+
+// Random search needs ~160 iterations to put the load between the stores,
+// directed one holds the load until the second store is about to run
+// and finds it in the first iterations (one per order of the pair).
+inline bool target_sites_test()
+{
+    rl::test_params params;
+    params.search_type = rl::sched_random;
+    if (simulate_quiet<race_window_test>(params))
+        return false;
+
+    rl::ostringstream targets;
+    targets << "search.hpp:" << race_window_test::check_line
+        << ",search.hpp:" << race_window_test::clear_line;
+    rl::test_params p;
+    p.search_type = rl::sched_random;
+    p.target_sites = targets.str();
+    if (simulate_quiet<race_window_test>(p))
+        return false;
+    return p.stop_iteration <= 2 && p.stop_iteration * 4 < params.stop_iteration;
+}
+
+
+
+
+struct child_order_test : rl::test_suite<child_order_test, 3>
+{
+    rl::atomic<int> a;
+    char order [7];
+
+    void before()
+    {
+        a($) = 0;
+    }
+
+    void thread(unsigned index)
+    {
+        for (int i = 0; i != 2; ++i)
+            order[a($).fetch_add(1, rl::memory_order_relaxed)] = (char)('0' + index);
+    }
+
+    // interleaving, mapped to the order in which it was first seen
+    void after()
+    {
+        order[6] = 0;
+        int& first = (*seen_executions())[order];
+        if (0 == first)
+            first = (int)seen_executions()->size();
+    }
+};
+
+inline rl::string first_execution(rl::rl_map<rl::string, int> const& seen)
+{
+    for (rl::rl_map<rl::string, int>::const_iterator i = seen.begin(); i != seen.end(); ++i)
+    {
+        if (1 == i->second)
+            return i->first;
+    }
+    return rl::string();
+}
+
+// Seeded order of branches (replay states are in terms of permuted branches)
+// explores the same number of executions with the same interleavings,
+// but seeds start from different ones.
+inline bool child_order_seed_test()
+{
+    rl::scheduler_type_e const types [] = {rl::sched_full, rl::sched_bound};
+    for (size_t t = 0; t != sizeof(types) / sizeof(*types); ++t)
+    {
+        rl::iteration_t count = 0;
+        rl::rl_map<rl::string, int> unseeded;
+        bool moved = false;
+        unsigned const seeds [] = {0, 1, 7};
+        for (size_t s = 0; s != sizeof(seeds) / sizeof(*seeds); ++s)
+        {
+            rl::rl_map<rl::string, int> seen;
+            seen_executions() = &seen;
+            rl::test_params params;
+            params.search_type = types[t];
+            params.context_bound = 2;
+            params.child_order_seed = seeds[s];
+            bool const passed = simulate_quiet<child_order_test>(params);
+            seen_executions() = 0;
+
+            if (false == passed)
+                return false;
+            if (0 == s)
+            {
+                count = params.stop_iteration;
+                unseeded.swap(seen);
+                continue;
+            }
+            if (params.stop_iteration != count || seen.size() != unseeded.size())
+                return false;
+            moved = moved || first_execution(seen) != first_execution(unseeded);
+            for (rl::rl_map<rl::string, int>::const_iterator i = seen.begin(); i != seen.end(); ++i)
+            {
+                if (0 == unseeded.count(i->first))
+                    return false;
+            }
+        }
+        if (false == moved)
+            return false;
+    }
+    return true;
+}
+
+
+
+
+// Swarm configuration is drawn from the iteration number: runs find
+// the same failing iteration, and its state replays it alone.
+inline bool swarm_test()
+{
+    rl::string state;
+    rl::iteration_t iteration = 0;
+    for (int run = 0; run != 2; ++run)
+    {
+        rl::test_params params;
+        params.search_type = rl::sched_random;
+        params.swarm = true;
+        if (simulate_quiet<corpus_test>(params)
+            || (run && (params.stop_iteration != iteration || params.final_state != state)))
+            return false;
+        iteration = params.stop_iteration;
+        state = params.final_state;
+    }
+
+    rl::test_params p;
+    p.search_type = rl::sched_random;
+    p.swarm = true;
+    p.initial_state = state;
+    p.iteration_count = 1;
+    return 1 < iteration
+        && false == simulate_quiet<corpus_test>(p)
+        && p.stop_iteration == iteration
+        && p.final_state == state;
+}
+
+
+
+
+struct symmetric_test : rl::test_suite<symmetric_test, 3>
+{
+    static rl::thread_id_t symmetry_group(rl::thread_id_t index)
+    {
+        return index ? 0 : -1;
+    }
+
+    rl::atomic<int> x;
+
+    void before()
+    {
+        x($) = 0;
+    }
+
+    void thread(unsigned index)
+    {
+        if (0 == index)
+        {
+            x($).store(1);
+            x($).store(2);
+            x($).store(3);
+        }
+        else
+        {
+            int const v = x($).load();
+            RL_ASSERT(v != 1);
+        }
+    }
+};
+
+// The failure needs thread 0 preempted while thread 2 is filtered out
+// as a symmetric duplicate of thread 1, minimization must see
+// that switch as the preemption it is.
+inline bool symmetric_minimize_test()
+{
+    rl::scheduler_type_e const types [] = {rl::sched_full, rl::sched_bound};
+    for (size_t t = 0; t != sizeof(types) / sizeof(*types); ++t)
+    {
+        rl::test_params params;
+        params.search_type = types[t];
+        if (simulate_quiet<symmetric_test>(params))
+            return false;
+
+        rl::test_params p;
+        p.search_type = types[t];
+        p.initial_state = params.final_state;
+        p.minimize_schedule = true;
+        rl::ostringstream stream;
+        p.output_stream = &stream;
+        p.progress_stream = &stream;
+        if (rl::simulate<symmetric_test>(p)
+            || rl::string::npos == stream.str().find("schedule minimized: 1 -> 1 preemptions")
+            || p.final_state != params.final_state)
+            return false;
+    }
+    return true;
+}
+
+
+
+
+template<int second_flag, bool check>
+struct restore_test : rl::test_suite<restore_test<second_flag, check>, 2>
+{
+    rl::atomic<int> data;
+    rl::atomic<int> flag;
+
+    void before()
+    {
+        data($) = 0;
+        flag($) = 0;
+    }
+
+    void thread(unsigned index)
+    {
+        if (0 == index)
+        {
+            data($).store(1, rl::memory_order_relaxed);
+            // no release, the message passing is broken
+            flag($).store(1, rl::memory_order_relaxed);
+            flag($).store(second_flag, rl::memory_order_relaxed);
+        }
+        else
+        {
+            int const f = flag($).load(rl::memory_order_acquire);
+            int const d = data($).load(rl::memory_order_relaxed);
+            RL_ASSERT(false == check || 0 == f || 1 == d);
+        }
+    }
+};
+
+// Loads of a flag stored twice with the same value explore fewer executions
+// than with different values (without the pruning both explore the same
+// number), message passing bug is still found.
+inline bool restore_pruning_test()
+{
+    rl::scheduler_type_e const types [] = {rl::sched_full, rl::sched_bound};
+    for (size_t t = 0; t != sizeof(types) / sizeof(*types); ++t)
+    {
+        rl::test_params same;
+        same.search_type = types[t];
+        rl::test_params different;
+        different.search_type = types[t];
+        if (false == simulate_quiet<restore_test<1, false> >(same)
+            || false == simulate_quiet<restore_test<2, false> >(different)
+            || same.stop_iteration >= different.stop_iteration)
+            return false;
+
+        rl::test_params bug;
+        bug.search_type = types[t];
+        if (simulate_quiet<restore_test<1, true> >(bug)
+            || rl::test_result_user_assert_failed != bug.test_result)
+            return false;
+    }
+    return true;
+}
+
+
+
+
+// outcomes (values loaded by an execution, one bit per combination)
+// seen by the current simulation
+inline uint64_t& seen_outcomes()
+{
+    static uint64_t outcomes = 0;
+    return outcomes;
+}
+
+// Store buffering.
+template<rl::memory_order mo>
+struct por_sb_test : rl::test_suite<por_sb_test<mo>, 2>
+{
+    rl::atomic<int> x;
+    rl::atomic<int> y;
+    int r [2];
+
+    void before()
+    {
+        x($) = 0;
+        y($) = 0;
+    }
+
+    void thread(unsigned index)
+    {
+        (index ? y : x)($).store(1, mo);
+        r[index] = (index ? x : y)($).load(mo);
+    }
+
+    void after()
+    {
+        seen_outcomes() |= 1ull << (r[0] * 2 + r[1]);
+    }
+};
+
+// Independent reads of independent writes.
+template<rl::memory_order mo>
+struct por_iriw_test : rl::test_suite<por_iriw_test<mo>, 4>
+{
+    rl::atomic<int> x;
+    rl::atomic<int> y;
+    int r [4];
+
+    void before()
+    {
+        x($) = 0;
+        y($) = 0;
+    }
+
+    void thread(unsigned index)
+    {
+        if (index < 2)
+        {
+            (index ? y : x)($).store(1, mo);
+        }
+        else
+        {
+            r[index - 2] = (3 == index ? y : x)($).load(mo);
+            r[index] = (3 == index ? x : y)($).load(mo);
+        }
+    }
+
+    void after()
+    {
+        seen_outcomes() |= 1ull << (r[0] * 8 + r[1] * 4 + r[2] * 2 + r[3]);
+    }
+};
+
+// Message passing.
+template<rl::memory_order store_mo, rl::memory_order load_mo>
+struct por_mp_test : rl::test_suite<por_mp_test<store_mo, load_mo>, 2>
+{
+    rl::atomic<int> data;
+    rl::atomic<int> flag;
+    int r [2];
+
+    void before()
+    {
+        data($) = 0;
+        flag($) = 0;
+    }
+
+    void thread(unsigned index)
+    {
+        if (0 == index)
+        {
+            data($).store(1, rl::memory_order_relaxed);
+            flag($).store(1, store_mo);
+        }
+        else
+        {
+            r[0] = flag($).load(load_mo);
+            r[1] = data($).load(rl::memory_order_relaxed);
+        }
+    }
+
+    void after()
+    {
+        seen_outcomes() |= 1ull << (r[0] * 2 + r[1]);
+    }
+};
+
+// Store buffering with a weak CAS, which can fail spuriously.
+struct por_cas_test : rl::test_suite<por_cas_test, 3>
+{
+    rl::atomic<int> x;
+    rl::atomic<int> y;
+    int r [3];
+
+    void before()
+    {
+        x($) = 0;
+        y($) = 0;
+    }
+
+    void thread(unsigned index)
+    {
+        if (0 == index)
+        {
+            x($).store(1, rl::memory_order_relaxed);
+            r[0] = y($).load(rl::memory_order_relaxed);
+        }
+        else if (1 == index)
+        {
+            int cmp = 0;
+            r[1] = y($).compare_exchange_weak(cmp, 1, rl::memory_order_relaxed);
+            r[2] = x($).load(rl::memory_order_relaxed);
+        }
+        else
+        {
+            y($).fetch_add(2, rl::memory_order_relaxed);
+        }
+    }
+
+    void after()
+    {
+        seen_outcomes() |= 1ull << (r[0] * 4 + r[1] * 2 + r[2]);
+    }
+};
+
+template<typename test_t>
+bool same_outcomes_with_por()
+{
+    uint64_t outcomes [2];
+    for (int por = 0; por != 2; ++por)
+    {
+        seen_outcomes() = 0;
+        rl::test_params params;
+        params.search_type = rl::sched_full;
+        params.partial_order_reduction = 0 != por;
+        if (false == simulate_quiet<test_t>(params))
+            return false;
+        outcomes[por] = seen_outcomes();
+    }
+    return outcomes[0] && outcomes[0] == outcomes[1];
+}
+
+// Sleep sets skip only reorderings, every outcome is still reached.
+inline bool por_outcomes_test()
+{
+    return same_outcomes_with_por<por_sb_test<rl::memory_order_seq_cst> >()
+        && same_outcomes_with_por<por_sb_test<rl::memory_order_relaxed> >()
+        && same_outcomes_with_por<por_iriw_test<rl::memory_order_seq_cst> >()
+        && same_outcomes_with_por<por_iriw_test<rl::memory_order_relaxed> >()
+        && same_outcomes_with_por<por_mp_test<rl::memory_order_release, rl::memory_order_acquire> >()
+        && same_outcomes_with_por<por_mp_test<rl::memory_order_relaxed, rl::memory_order_relaxed> >()
+        && same_outcomes_with_por<por_cas_test>();
+}
+
+
+
+
+// Thread 1 waits for the flag yielding, the loop repeats the same state
+// for as long as thread 0 doesn't run.
+template<bool hash, bool check>
+struct state_hash_test : rl::test_suite<state_hash_test<hash, check>, 2>
+{
+    rl::atomic<int> data;
+    rl::atomic<int> flag;
+
+    void before()
+    {
+        data($) = 0;
+        flag($) = 0;
+    }
+
+    void thread(unsigned index)
+    {
+        if (0 == index)
+        {
+            data($).store(1, rl::memory_order_relaxed);
+            flag($).store(1, check ? rl::memory_order_relaxed : rl::memory_order_release);
+        }
+        else
+        {
+            while (0 == flag($).load(rl::memory_order_acquire))
+                rl::yield(1, $);
+            int const d = data($).load(rl::memory_order_relaxed);
+            RL_ASSERT(1 == d);
+        }
+    }
+
+    size_t state_hash()
+    {
+        return hash ? 1 : 0;
+    }
+};
+
+// Waiting loop is explored once per state with the hash, the bug of the
+// relaxed flag is still found.
+inline bool state_hash_cut_test()
+{
+    rl::test_params with_hash;
+    with_hash.search_type = rl::sched_full;
+    rl::test_params without_hash;
+    without_hash.search_type = rl::sched_full;
+    if (false == simulate_quiet<state_hash_test<true, false> >(with_hash)
+        || false == simulate_quiet<state_hash_test<false, false> >(without_hash)
+        || with_hash.stop_iteration >= without_hash.stop_iteration)
+        return false;
+
+    rl::test_params bug;
+    bug.search_type = rl::sched_full;
+    return false == simulate_quiet<state_hash_test<true, true> >(bug)
+        && rl::test_result_user_assert_failed == bug.test_result;
+}
+
+
+
+
+// Thread 1 spins on a CAS (without yield) until thread 0 stores,
+// or forever if nobody stores.
+template<bool stored>
+struct spin_loop_test : rl::test_suite<spin_loop_test<stored>, 2>
+{
+    rl::atomic<int> x;
+
+    void before()
+    {
+        x($) = 0;
+    }
+
+    void thread(unsigned index)
+    {
+        if (0 == index)
+        {
+            if (stored)
+                x($).store(1, rl::memory_order_relaxed);
+        }
+        else
+        {
+            int cmp = 1;
+            while (false == x($).compare_exchange_strong(cmp, 2, rl::memory_order_relaxed))
+                cmp = 1;
+        }
+    }
+};
+
+// A spin-loop is a livelock for full search unless it is detected,
+// a loop nobody ends is still reported.
+inline bool spin_loop_detect_test()
+{
+    rl::test_params plain;
+    plain.search_type = rl::sched_full;
+    if (simulate_quiet<spin_loop_test<true> >(plain)
+        || rl::test_result_livelock != plain.test_result)
+        return false;
+
+    rl::test_params detect;
+    detect.search_type = rl::sched_full;
+    detect.detect_spin_loops = true;
+    if (false == simulate_quiet<spin_loop_test<true> >(detect))
+        return false;
+
+    rl::test_params stuck;
+    stuck.search_type = rl::sched_full;
+    stuck.detect_spin_loops = true;
+    return false == simulate_quiet<spin_loop_test<false> >(stuck)
+        && rl::test_result_livelock == stuck.test_result;
+}